@@ -0,0 +1,100 @@
+#include <atomic>
+#include <bsio/Bsio.hpp>
+#include <bsio/net/wrapper/AcceptorBuilder.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+using namespace bsio::net;
+
+static std::atomic<size_t> AllocationNum{0};
+
+void* operator new(size_t size)
+{
+    AllocationNum.fetch_add(1, std::memory_order_relaxed);
+    if (auto p = std::malloc(size == 0 ? 1 : size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+// count heap allocations of an echo loop after warm up,
+// the recurring receive and write operations of session should not allocate.
+int main(int argc, char** argv)
+{
+    if (argc != 4)
+    {
+        fprintf(stderr, "Usage: <port> <round trips> <packet size>\n");
+        exit(-1);
+    }
+
+    const auto port = static_cast<unsigned short>(std::atoi(argv[1]));
+    const auto roundTrips = static_cast<size_t>(std::atoi(argv[2]));
+    const auto packetSize = static_cast<size_t>(std::atoi(argv[3]));
+
+    IoContextThread serverContext(1);
+    serverContext.start(1);
+
+    // reply with the same preallocated message, so only the library allocates.
+    const auto reply = MakeStringMsg(std::string(packetSize, 'e'));
+    auto acceptor = TcpAcceptor::Make(serverContext.context(),
+                                      std::make_shared<FixedIoContextProvider>(serverContext.context()),
+                                      asio::ip::tcp::endpoint(asio::ip::tcp::v4(), port));
+    wrapper::TcpSessionAcceptorBuilder builder;
+    builder.WithAcceptor(acceptor)
+            .WithRecvBufferSize(packetSize * 4)
+            .WithSessionOptionBuilder([=](wrapper::SessionOptionBuilder& option) {
+                option.WithDataHandler([=](const TcpSession::Ptr& session, bsio::base::BasePacketReader& reader) {
+                    while (reader.enough(packetSize))
+                    {
+                        session->send(reply);
+                        reader.addPos(packetSize);
+                        reader.savePos();
+                    }
+                });
+            })
+            .start();
+
+    // blocking client does not allocate per operation.
+    asio::io_context clientContext;
+    asio::ip::tcp::socket client(clientContext);
+    client.connect(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), port));
+    client.set_option(asio::ip::tcp::no_delay(true));
+    std::string request(packetSize, 'e');
+    std::string response(packetSize, 0);
+
+    const auto echo = [&](size_t num) {
+        for (size_t i = 0; i < num; i++)
+        {
+            asio::write(client, asio::buffer(request));
+            asio::read(client, asio::buffer(&response[0], response.size()));
+        }
+    };
+
+    echo(1000);
+    const auto before = AllocationNum.load();
+    echo(roundTrips);
+    const auto allocations = AllocationNum.load() - before;
+
+    std::cout << "round trips:" << roundTrips
+              << " allocations:" << allocations
+              << " per round trip:" << static_cast<double>(allocations) / roundTrips
+              << std::endl;
+
+    client.close();
+    acceptor->close();
+    serverContext.stop();
+
+    return 0;
+}
@@ -1,5 +1,6 @@
 ﻿#include <asio/signal_set.hpp>
 #include <bsio/net/IoContextThreadPool.hpp>
+#include <bsio/net/SessionRegistry.hpp>
 #include <bsio/net/wrapper/AcceptorBuilder.hpp>
 #include <iostream>
 
@@ -8,7 +9,10 @@ using namespace asio::ip;
 using namespace bsio;
 using namespace bsio::net;
 
-std::vector<TcpSession::Ptr> clients;
+// sessions are registered and removed by io threads, and broadcast from io threads directly.
+const auto clients = SessionRegistry::Make();
+// slow clients are closed when queued bytes of all clients reach the limit.
+const auto memoryBudget = MemoryBudget::Make(512 * 1024 * 1024, 1024 * 1024 * 1024, MemoryBudgetPolicy{false, false, true});
 
 std::atomic_llong TotalSendLen = ATOMIC_VAR_INIT(0);
 std::atomic_llong TotalRecvLen = ATOMIC_VAR_INIT(0);
@@ -18,26 +22,9 @@ std::atomic_llong RecvPacketNum = ATOMIC_VAR_INIT(0);
 
 std::atomic_llong SendingNum = ATOMIC_VAR_INIT(0);
 
-static void addClientID(const TcpSession::Ptr &session)
-{
-    clients.push_back(session);
-}
-
-static void removeClientID(const TcpSession::Ptr &session)
-{
-    for (auto it = clients.begin(); it != clients.end(); ++it)
-    {
-        if (*it == session)
-        {
-            clients.erase(it);
-            break;
-        }
-    }
-}
-
 static size_t getClientNum()
 {
-    return clients.size();
+    return clients->size();
 }
 
 static void broadCastPacket(const bsio::net::SendableMsg::Ptr &packet)
@@ -46,16 +33,17 @@ static void broadCastPacket(const bsio::net::SendableMsg::Ptr &packet)
     RecvPacketNum.fetch_add(1);
     TotalRecvLen += packetLen;
 
-    for (const auto &session : clients)
-    {
+    size_t clientNum = 0;
+    clients->forEach([&](SessionRegistry::SessionId, const TcpSession::Ptr &session) {
         SendingNum.fetch_add(1);
         session->send(packet, []() {
             SendingNum.fetch_sub(1);
         });
-    }
+        clientNum++;
+    });
 
-    SendPacketNum += clients.size();
-    TotalSendLen += (clients.size() * packetLen);
+    SendPacketNum += clientNum;
+    TotalSendLen += (clientNum * packetLen);
 }
 
 int main(int argc, char **argv)
@@ -94,9 +82,9 @@ int main(int argc, char **argv)
                 //socket.set_option(rdBufSizeOption);
             })
             .WithRecvBufferSize(1024)
-            .WithSessionOptionBuilder([=, &mainLoop](wrapper::SessionOptionBuilder &builder) {
+            .WithSessionOptionBuilder([=](wrapper::SessionOptionBuilder &builder) {
                 // here, you can initialize your session user data
-                auto handler = [=, &mainLoop](const TcpSession::Ptr &session, bsio::base::BasePacketReader &reader) {
+                auto handler = [=](const TcpSession::Ptr &session, bsio::base::BasePacketReader &reader) {
                     while (true)
                     {
                         const auto buffer = reader.currentBuffer();
@@ -120,27 +108,18 @@ int main(int argc, char **argv)
                             break;
                         }
 
-                        auto packet = bsio::net::MakeStringMsg(buffer, packetLen + sizeof(uint32_t));
-                        mainLoop.context().dispatch([packet]() {
-                            broadCastPacket(packet);
-                        });
+                        broadCastPacket(bsio::net::MakeStringMsg(buffer, packetLen + sizeof(uint32_t)));
 
                         reader.addPos(packetLen - sizeof(uint32_t));
                         reader.savePos();
                     }
                 };
 
-                builder.AddEstablishHandler([&mainLoop, handler](const TcpSession::Ptr &session) {
-                           mainLoop.context().dispatch([session]() {
-                               addClientID(session);
-                           });
-                       })
+                builder.AddEstablishHandler(clients->establishHandler())
+                        .WithMemoryBudget(memoryBudget)
                         .WithDataHandler(handler)
-                        .WithClosedHandler([&mainLoop](const TcpSession::Ptr &session) {
+                        .WithClosedHandler([](const TcpSession::Ptr &session) {
                             std::cout << "connection closed" << std::endl;
-                            mainLoop.context().dispatch([session]() {
-                                removeClientID(session);
-                            });
                         });
             })
             .start();
@@ -150,24 +129,23 @@ int main(int argc, char **argv)
         mainLoop.stop();
     });
 
-    std::shared_ptr<std::function<void()>> logTimer;
-    logTimer = std::make_shared<std::function<void()>>([&]() {
+    auto logTimer = mainLoop.runEvery(std::chrono::seconds(1), [&]() {
         std::cout << "client num: " << getClientNum() << ", "
                   << "recv " << (TotalRecvLen / 1024) << " K/s, "
                   << "recv packet num: " << RecvPacketNum << ", "
                   << "send " << (TotalSendLen / 1024) / 1024 << " M/s, "
                   << "send packet num: " << SendPacketNum << ", "
-                  << "SendingNum: " << SendingNum.load()
+                  << "SendingNum: " << SendingNum.load() << ", "
+                  << "memory: " << memoryBudget->usedBytes() / 1024 / 1024 << " M"
                   << std::endl;
         TotalRecvLen = 0;
         TotalSendLen = 0;
         RecvPacketNum = 0;
         SendPacketNum = 0;
-        mainLoop.runAfter(std::chrono::seconds(1), *logTimer);
     });
-    mainLoop.runAfter(std::chrono::seconds(1), *logTimer);
 
     mainLoop.run();
+    logTimer->cancel();
 
     listenContextWrapper.stop();
     ioContextThreadPool->stop();
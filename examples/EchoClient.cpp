@@ -3,6 +3,7 @@
 #include <bsio/net/wrapper/ConnectorBuilder.hpp>
 #include <chrono>
 #include <iostream>
+#include <thread>
 
 using namespace bsio;
 using namespace bsio::net;
@@ -13,13 +13,13 @@ std::atomic<int64_t> count = {0};
 
 int main(int argc, char **argv)
 {
-    if (argc != 6)
+    if (argc != 6 && argc != 7)
     {
         fprintf(stderr,
                 "Usage: <port> "
                 " <thread pool size> <concurrencyHint>"
                 " <thread num one context> "
-                " <packet size> \n");
+                " <packet size> [use strand, default is 1 if thread num one context > 1]\n");
         exit(-1);
     }
 
@@ -32,6 +32,8 @@ int main(int argc, char **argv)
     listenContextWrapper.start(1);
 
     auto packetSize = std::atoi(argv[5]);
+    // sessions must be serialized if context is run by multi threads.
+    const auto useStrand = argc == 7 ? std::atoi(argv[6]) != 0 : std::atoi(argv[4]) > 1;
 
     TcpAcceptor::Ptr acceptor = TcpAcceptor::Make(
             listenContextWrapper.context(),
@@ -58,6 +60,10 @@ int main(int argc, char **argv)
                         .WithDataHandler(handler)
                         .WithClosedHandler([](const TcpSession::Ptr &) {
                         });
+                if (useStrand)
+                {
+                    builder.WithStrand();
+                }
             })
             .start();
 
@@ -0,0 +1,91 @@
+#include <atomic>
+#include <bsio/Bsio.hpp>
+#include <bsio/net/http/HttpClient.hpp>
+#include <chrono>
+#include <iostream>
+
+using namespace bsio;
+using namespace bsio::net;
+
+// sends requests to HttpServer example through the keep-alive pool, with at most
+// concurrency requests outstanding.
+int main(int argc, char **argv)
+{
+    if (argc != 8)
+    {
+        fprintf(stderr,
+                "Usage: <host> <port> <path> <request num> <concurrency>"
+                " <max connections> <pipeline depth>\n");
+        exit(-1);
+    }
+
+    IoContextThreadPool::Ptr ioContextPool = IoContextThreadPool::Make(1, 1);
+    ioContextPool->start(1);
+
+    const auto endpoint = asio::ip::tcp::endpoint(
+            asio::ip::address_v4::from_string(argv[1]), std::atoi(argv[2]));
+    const auto requestNum = std::atoi(argv[4]);
+    const auto concurrency = std::atoi(argv[5]);
+
+    http::HttpClientOptions options;
+    options.maxConnectionsPerHost = std::atoi(argv[6]);
+    options.maxIdleConnectionsPerHost = options.maxConnectionsPerHost;
+    options.pipelineDepth = std::atoi(argv[7]);
+    auto client = http::HttpClient::Make(ioContextPool, options);
+
+    http::HttpRequest request;
+    request.setUrl(argv[3]);
+    request.setHost(argv[1]);
+
+    // a blocking request first
+    try
+    {
+        const auto response = client->request(endpoint, request).get();
+        std::cout << "status:" << response->statusCode() << ", body size:" << response->body().size() << std::endl;
+    }
+    catch (const std::system_error &e)
+    {
+        std::cout << "request failed:" << e.what() << std::endl;
+        return -1;
+    }
+
+    std::atomic<int> sent{0};
+    std::atomic<int> completed{0};
+    std::atomic<int> failed{0};
+    std::function<void()> sendOne;
+    sendOne = [&]() {
+        if (sent.fetch_add(1) >= requestNum)
+        {
+            return;
+        }
+        client->request(endpoint, request, [&](std::error_code ec, http::HttpClientResponse::Ptr) {
+            if (ec)
+            {
+                failed++;
+            }
+            completed++;
+            sendOne();
+        });
+    };
+
+    const auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < concurrency; i++)
+    {
+        sendOne();
+    }
+    while (completed.load() < requestNum)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const auto cost = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin);
+
+    std::cout << requestNum << " requests, " << failed.load() << " failed, "
+              << cost.count() / 1000 << " ms, "
+              << (cost.count() > 0 ? static_cast<int64_t>(requestNum) * 1000000 / cost.count() : 0) << " req/s, "
+              << client->connectionNum(endpoint) << " connections" << std::endl;
+
+    client = nullptr;
+    ioContextPool->stop();
+
+    return 0;
+}
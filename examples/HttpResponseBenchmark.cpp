@@ -0,0 +1,80 @@
+#include <bsio/net/http/HttpFormat.hpp>
+#include <bsio/net/http/HttpResponseWriter.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+using namespace bsio::net;
+using namespace bsio::net::http;
+
+using Clock = std::chrono::steady_clock;
+
+// keep the result alive, so the compiler can't drop the work.
+static size_t Sink = 0;
+
+template<typename F>
+static void run(const char* name, size_t num, F f)
+{
+    // warm up pools and caches
+    for (size_t i = 0; i < 1000; i++)
+    {
+        f();
+    }
+
+    const auto start = Clock::now();
+    for (size_t i = 0; i < num; i++)
+    {
+        f();
+    }
+    const auto cost = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+    std::cout << name << ": " << cost.count() / num << " ns/response" << std::endl;
+}
+
+// serialize the same keep-alive response by HttpResponse::getResult and by HttpResponseWriter.
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "Usage: <response num> <body size>\n");
+        exit(-1);
+    }
+
+    const auto num = static_cast<size_t>(std::atoi(argv[1]));
+    const std::string body(static_cast<size_t>(std::atoi(argv[2])), 'b');
+    // shared by all responses, like a cached page
+    const auto bodyMsg = MakeStringMsg(body);
+
+    run("HttpResponse::getResult", num, [&]() {
+        HttpResponse resp;
+        resp.setContentType("text/plain");
+        resp.addHeadValue("Connection", "Keep-Alive");
+        resp.addHeadValue("Server", "bsio");
+        resp.setBody(body);
+        const auto msg = MakeStringMsg(resp.getResult());
+        Sink += msg->size();
+    });
+
+    run("HttpResponseWriter copy body", num, [&]() {
+        HttpResponseWriter writer;
+        writer.setContentType("text/plain")
+                .addHeader("Connection", "Keep-Alive")
+                .addHeader("Server", "bsio")
+                .setBody(body);
+        const auto [head, payload] = writer.finish();
+        Sink += head->size() + payload->size();
+    });
+
+    run("HttpResponseWriter shared body", num, [&]() {
+        HttpResponseWriter writer;
+        writer.setContentType("text/plain")
+                .addHeader("Connection", "Keep-Alive")
+                .addHeader("Server", "bsio")
+                .setBody(bodyMsg);
+        const auto [head, payload] = writer.finish();
+        Sink += head->size() + payload->size();
+    });
+
+    std::cout << "bytes: " << Sink << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include <bsio/net/http/HttpRouter.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+using namespace bsio::net;
+using namespace bsio::net::http;
+
+using Clock = std::chrono::steady_clock;
+
+// routes shaped like a REST api, such as /api/v2/resource17/:id/action3.
+static std::vector<std::string> makeRoutes(size_t routeNum)
+{
+    std::vector<std::string> routes;
+    for (size_t i = 0; routes.size() < routeNum; i++)
+    {
+        const auto base = "/api/v" + std::to_string(i % 3 + 1) + "/resource" + std::to_string(i / 3);
+        routes.push_back(base);
+        routes.push_back(base + "/:id");
+        for (size_t action = 0; action < 4 && routes.size() < routeNum; action++)
+        {
+            routes.push_back(base + "/:id/action" + std::to_string(action));
+        }
+        routes.push_back("/static/bundle" + std::to_string(i) + "/*path");
+    }
+    routes.resize(routeNum);
+    return routes;
+}
+
+// a path matching each route.
+static std::string makePath(const std::string& route)
+{
+    std::string path;
+    for (size_t i = 0; i < route.size(); i++)
+    {
+        if (route[i] == ':')
+        {
+            path += "12345";
+            while (i + 1 < route.size() && route[i + 1] != '/')
+            {
+                i++;
+            }
+        }
+        else if (route[i] == '*')
+        {
+            path += "js/app.min.js";
+            break;
+        }
+        else
+        {
+            path += route[i];
+        }
+    }
+    return path;
+}
+
+static void run(const char* name, const HttpRouter& router, const std::vector<std::string>& paths, size_t num)
+{
+    size_t found = 0;
+    size_t paramNum = 0;
+    RouteParams params;
+    const auto start = Clock::now();
+    for (size_t i = 0; i < num; i++)
+    {
+        if (router.match(HTTP_GET, paths[i % paths.size()], params) != nullptr)
+        {
+            found++;
+            paramNum += params.size();
+        }
+    }
+    const auto cost = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+    std::cout << name << ": " << cost.count() / num << " ns/match, "
+              << "found " << found << ", params " << paramNum << std::endl;
+}
+
+// match paths of all routes in random order before and after freezing the router.
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "Usage: <route num> <match num>\n");
+        exit(-1);
+    }
+
+    const auto routeNum = static_cast<size_t>(std::atoi(argv[1]));
+    const auto matchNum = static_cast<size_t>(std::atoi(argv[2]));
+
+    const auto routes = makeRoutes(routeNum);
+    auto router = HttpRouter::Make();
+    std::vector<std::string> paths;
+    for (const auto& route : routes)
+    {
+        router->get(route, [](const HTTPParser&, const HttpSession::Ptr&, const RouteParams&) {
+        });
+        paths.push_back(makePath(route));
+    }
+    std::shuffle(paths.begin(), paths.end(), std::mt19937(1));
+
+    run("radix tree", *router, paths, matchNum);
+    router->freeze();
+    run("frozen", *router, paths, matchNum);
+
+    return 0;
+}
@@ -1,6 +1,7 @@
 #include <asio/signal_set.hpp>
 #include <bsio/net/IoContextThreadPool.hpp>
-#include <bsio/net/http/HttpFormat.hpp>
+#include <bsio/net/http/HttpRouter.hpp>
+#include <bsio/net/http/StaticFileHandler.hpp>
 #include <bsio/net/wrapper/HttpAcceptorBuilder.hpp>
 #include <thread>
 
@@ -9,6 +10,25 @@ using namespace asio::ip;
 using namespace bsio;
 using namespace bsio::net;
 
+// responses of pipelined requests are sent in order of requests.
+static void respond(const http::HTTPParser &parser, const http::HttpSession::Ptr &session, std::string body)
+{
+    http::HttpResponseWriter writer;
+    writer.setBody(std::move(body));
+    if (parser.isKeepAlive())
+    {
+        writer.addHeader("Connection", "Keep-Alive");
+        session->sendResponse(std::move(writer));
+    }
+    else
+    {
+        writer.addHeader("Connection", "Close");
+        session->sendResponse(std::move(writer), [session]() {
+            session->shutdown(asio::ip::tcp::socket::shutdown_type::shutdown_both);
+        });
+    }
+}
+
 int main(int argc, char **argv)
 {
     if (argc != 5)
@@ -33,31 +53,40 @@ int main(int argc, char **argv)
             ioContextThreadPool,
             ip::tcp::endpoint(ip::tcp::v4(), std::atoi(argv[1])));
 
+    // routes are added before start, then the router is shared by all sessions.
+    auto router = http::HttpRouter::Make();
+    router->get("/", [](const http::HTTPParser &parser, const http::HttpSession::Ptr &session, const http::RouteParams &) {
+              respond(parser, session, "hello world");
+          })
+            .get("/users/:id", [](const http::HTTPParser &parser, const http::HttpSession::Ptr &session, const http::RouteParams &params) {
+                // params and parser.path() are views valid in this callback
+                respond(parser, session, "user " + std::string(params.get("id")));
+            })
+            .get("/stream/:count", [](const http::HTTPParser &, const http::HttpSession::Ptr &session, const http::RouteParams &params) {
+                // a producer in other thread can keep the stream and write when results are ready
+                http::HttpResponseWriter writer;
+                writer.setContentType("text/plain");
+                auto stream = session->startStreamResponse(std::move(writer));
+                const auto count = std::atoi(std::string(params.get("count")).c_str());
+                for (int i = 0; i < count; i++)
+                {
+                    stream->write("chunk " + std::to_string(i) + "\n");
+                }
+                stream->finish();
+            });
+    // files under ./www, such as /static/index.html
+    http::StaticFileHandler::Make("www")->mount(*router, "/static/");
+    router->freeze();
+
     wrapper::HttpAcceptorBuilder builder;
     builder.WithAcceptor(acceptor)
             .WithRecvBufferSize(1024)
-            .WithHttpSessionBuilder([](wrapper::HttpSessionBuilder &builder) {
+            .WithHttpSessionBuilder([=](wrapper::HttpSessionBuilder &builder) {
                 // here, you can initialize your session user data
-                builder.WithEnterCallback([](const bsio::net::http::HttpSession::Ptr &) {
-                       })
-                        .WithParserCallback([](const bsio::net::http::HTTPParser &parser, const bsio::net::http::HttpSession::Ptr &session) {
-                            // we can call parser.getPath() get the query path
-
-                            bsio::net::http::HttpResponse resp;
-                            resp.setBody("hello world");
-                            if (parser.isKeepAlive())
-                            {
-                                resp.addHeadValue("Connection", "Keep-Alive");
-                                session->send(resp.getResult());
-                            }
-                            else
-                            {
-                                resp.addHeadValue("Connection", "Close");
-                                session->send(resp.getResult(), [session]() {
-                                    session->shutdown(asio::ip::tcp::socket::shutdown_type::shutdown_both);
-                                });
-                            }
-                        });
+                builder.WithZeroCopyParser()
+                        .WithEnterCallback([](const http::HttpSession::Ptr &) {
+                        })
+                        .WithRouter(router);
             })
             .start();
 
@@ -0,0 +1,171 @@
+#include <bsio/Bsio.hpp>
+#include <bsio/base/WaitGroup.hpp>
+#include <bsio/net/Mailbox.hpp>
+#include <ctime>
+#include <iostream>
+#include <thread>
+
+using namespace bsio::net;
+
+using Clock = std::chrono::steady_clock;
+
+struct Entry {
+    uint64_t sessionId = 0;
+    uint64_t value = 0;
+};
+
+static std::chrono::nanoseconds threadCpuTime()
+{
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+// count messages in consumer thread, and measure consumer cpu time between first and last message.
+class Consumer
+{
+public:
+    Consumer(size_t total, bsio::base::WaitGroup::Ptr wg)
+        : mTotal(total),
+          mWaitGroup(std::move(wg))
+    {
+    }
+
+    void onEntry(const Entry& entry)
+    {
+        if (mCount == 0)
+        {
+            mStartCpuTime = threadCpuTime();
+        }
+        mSum += entry.value;
+        if (++mCount == mTotal)
+        {
+            mCpuTime = threadCpuTime() - mStartCpuTime;
+            mWaitGroup->done();
+        }
+    }
+
+    std::chrono::nanoseconds cpuTime() const
+    {
+        return mCpuTime;
+    }
+
+private:
+    const size_t mTotal;
+    const bsio::base::WaitGroup::Ptr mWaitGroup;
+    size_t mCount = 0;
+    uint64_t mSum = 0;
+    std::chrono::nanoseconds mStartCpuTime{0};
+    std::chrono::nanoseconds mCpuTime{0};
+};
+
+template<typename Push>
+static void runProducers(size_t producerNum, size_t msgNum, size_t rate, Push push)
+{
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < producerNum; p++)
+    {
+        producers.emplace_back([=]() {
+            const auto num = msgNum / producerNum;
+            const auto interval = std::chrono::nanoseconds(rate == 0 ? 0 : 1000000000ull * producerNum / rate);
+            auto next = Clock::now();
+            for (size_t i = 0; i < num; i++)
+            {
+                if (rate != 0)
+                {
+                    // pace in small batches
+                    if ((i & 63) == 0)
+                    {
+                        while (Clock::now() < next)
+                        {
+                            std::this_thread::yield();
+                        }
+                        next += interval * 64;
+                    }
+                }
+                push(Entry{p, i});
+            }
+        });
+    }
+    for (auto& producer : producers)
+    {
+        producer.join();
+    }
+}
+
+static void report(const char* name, size_t msgNum, Clock::duration cost, std::chrono::nanoseconds consumerCpu, size_t wakeupNum)
+{
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(cost).count();
+    std::cout << name
+              << " msgs:" << msgNum
+              << " cost:" << ms << "ms"
+              << " throughput:" << (ms > 0 ? msgNum * 1000 / ms : 0) << "/s"
+              << " consumer cpu:" << consumerCpu.count() / msgNum << "ns/msg";
+    if (wakeupNum > 0)
+    {
+        std::cout << " wakeups:" << wakeupNum;
+    }
+    std::cout << std::endl;
+}
+
+static void benchDispatch(size_t producerNum, size_t msgNum, size_t rate)
+{
+    IoContextThread logicLoop(1);
+    logicLoop.start(1);
+
+    auto wg = bsio::base::WaitGroup::Create();
+    wg->add(1);
+    Consumer consumer(msgNum, wg);
+
+    const auto start = Clock::now();
+    runProducers(producerNum, msgNum, rate, [&](Entry entry) {
+        asio::dispatch(logicLoop.context(), [&consumer, entry]() {
+            consumer.onEntry(entry);
+        });
+    });
+    wg->wait();
+    report("dispatch", msgNum, Clock::now() - start, consumer.cpuTime(), 0);
+    logicLoop.stop();
+}
+
+static void benchMailbox(size_t producerNum, size_t msgNum, size_t rate)
+{
+    IoContextThread logicLoop(1);
+    logicLoop.start(1);
+
+    auto wg = bsio::base::WaitGroup::Create();
+    wg->add(1);
+    Consumer consumer(msgNum, wg);
+    auto mailbox = Mailbox<Entry>::Make(logicLoop.wrapperIoContext(), 64 * 1024, [&](Entry& entry) {
+        consumer.onEntry(entry);
+    });
+
+    const auto start = Clock::now();
+    runProducers(producerNum, msgNum, rate, [&](Entry entry) {
+        while (!mailbox->push(entry))
+        {
+            std::this_thread::yield();
+        }
+    });
+    wg->wait();
+    report("mailbox ", msgNum, Clock::now() - start, consumer.cpuTime(), mailbox->wakeupNum());
+    logicLoop.stop();
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 4)
+    {
+        fprintf(stderr, "Usage: <producer num> <msg num> <msgs per second, 0 is unlimited>\n");
+        exit(-1);
+    }
+
+    const auto producerNum = static_cast<size_t>(std::atoi(argv[1]));
+    const auto msgNum = static_cast<size_t>(std::atoi(argv[2])) / producerNum * producerNum;
+    const auto rate = static_cast<size_t>(std::atoi(argv[3]));
+
+    benchDispatch(producerNum, msgNum, rate);
+    benchMailbox(producerNum, msgNum, rate);
+
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <bsio/Bsio.hpp>
+#include <bsio/base/WaitGroup.hpp>
+#include <bsio/net/wrapper/AcceptorBuilder.hpp>
+#include <bsio/net/wrapper/ConnectorBuilder.hpp>
+#include <iostream>
+#include <thread>
+
+using namespace bsio;
+using namespace bsio::net;
+
+using Clock = std::chrono::steady_clock;
+
+static void runPingPong(int port, size_t roundTrips, size_t packetSize, bool busyPoll)
+{
+    IoContextThread serverContext(1);
+    IoContextThread clientContext(1);
+    if (busyPoll)
+    {
+        BusyPollOption option;
+        option.socketBusyPoll = 50;
+        serverContext.wrapperIoContext().setBusyPoll(option);
+        clientContext.wrapperIoContext().setBusyPoll(option);
+    }
+    serverContext.start(1);
+    clientContext.start(1);
+
+    auto serverProvider = std::make_shared<FixedIoContextProvider>(serverContext.context());
+    auto acceptor = TcpAcceptor::Make(serverContext.context(),
+                                      serverProvider,
+                                      asio::ip::tcp::endpoint(asio::ip::tcp::v4(), port));
+    wrapper::TcpSessionAcceptorBuilder acceptorBuilder;
+    acceptorBuilder.WithAcceptor(acceptor)
+            .WithRecvBufferSize(packetSize)
+            .WithSessionOptionBuilder([=](wrapper::SessionOptionBuilder& builder) {
+                builder.WithDataHandler([=](const TcpSession::Ptr& session, bsio::base::BasePacketReader& reader) {
+                    while (reader.enough(packetSize))
+                    {
+                        session->send(std::string(reader.currentBuffer(), packetSize));
+                        reader.addPos(packetSize);
+                        reader.savePos();
+                    }
+                });
+            })
+            .start();
+
+    std::vector<Clock::duration> rtts;
+    rtts.reserve(roundTrips);
+    auto sendTime = std::make_shared<Clock::time_point>();
+    auto wg = bsio::base::WaitGroup::Create();
+    wg->add(1);
+
+    const auto packet = MakeStringMsg(std::string(packetSize, 'p'));
+    wrapper::TcpSessionConnectorBuilder connectorBuilder;
+    connectorBuilder.WithConnector(TcpConnector(std::make_shared<FixedIoContextProvider>(clientContext.context())))
+            .WithEndpoint(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), port))
+            .WithTimeout(std::chrono::seconds(10))
+            .WithFailedHandler([wg]() {
+                std::cout << "connect failed" << std::endl;
+                wg->done();
+            })
+            .WithRecvBufferSize(packetSize)
+            .AddEstablishHandler([=](const TcpSession::Ptr& session) {
+                *sendTime = Clock::now();
+                session->send(packet);
+            })
+            .WithDataHandler([=, &rtts](const TcpSession::Ptr& session, bsio::base::BasePacketReader& reader) {
+                while (reader.enough(packetSize))
+                {
+                    reader.addPos(packetSize);
+                    reader.savePos();
+
+                    rtts.push_back(Clock::now() - *sendTime);
+                    if (rtts.size() == roundTrips)
+                    {
+                        session->close();
+                        wg->done();
+                        return;
+                    }
+                    *sendTime = Clock::now();
+                    session->send(packet);
+                }
+            })
+            .asyncConnect();
+
+    wg->wait();
+    acceptor->close();
+    clientContext.stop();
+    serverContext.stop();
+
+    if (rtts.empty())
+    {
+        return;
+    }
+    std::sort(rtts.begin(), rtts.end());
+    const auto percentile = [&](double p) {
+        const auto index = std::min(rtts.size() - 1, static_cast<size_t>(p * rtts.size()));
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(rtts[index]).count() / 1000.0;
+    };
+    std::cout << (busyPoll ? "busy poll" : "blocking ")
+              << " round trips:" << rtts.size()
+              << " p50:" << percentile(0.5) << "us"
+              << " p99:" << percentile(0.99) << "us"
+              << " p999:" << percentile(0.999) << "us"
+              << " max:" << percentile(1.0) << "us"
+              << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 4)
+    {
+        fprintf(stderr,
+                "Usage: <port> <round trips> <packet size>\n");
+        exit(-1);
+    }
+
+    const auto port = std::atoi(argv[1]);
+    const auto roundTrips = static_cast<size_t>(std::atoi(argv[2]));
+    const auto packetSize = static_cast<size_t>(std::atoi(argv[3]));
+
+    runPingPong(port, roundTrips, packetSize, false);
+    runPingPong(port, roundTrips, packetSize, true);
+
+    return 0;
+}
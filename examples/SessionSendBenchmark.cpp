@@ -0,0 +1,215 @@
+#include <bsio/Bsio.hpp>
+#include <bsio/net/wrapper/AcceptorBuilder.hpp>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace bsio::net;
+
+using Clock = std::chrono::steady_clock;
+
+// counts user space events of this process, including threads created after open.
+class PerfCounter
+{
+public:
+    PerfCounter(const char* name, uint32_t type, uint64_t config)
+        : mName(name)
+    {
+#ifdef __linux__
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        mFd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        if (mFd >= 0)
+        {
+            ioctl(mFd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    ~PerfCounter()
+    {
+#ifdef __linux__
+        if (mFd >= 0)
+        {
+            close(mFd);
+        }
+#endif
+    }
+
+    void print() const
+    {
+        std::cout << mName << ":";
+        uint64_t value = 0;
+#ifdef __linux__
+        if (mFd >= 0 && read(mFd, &value, sizeof(value)) == sizeof(value))
+        {
+            std::cout << value << std::endl;
+            return;
+        }
+#endif
+        std::cout << "n/a" << std::endl;
+    }
+
+private:
+    const char* mName;
+    int mFd = -1;
+};
+
+// several threads send to one session while its io thread is busy receiving,
+// so send() of producers and the receive path of io thread touch the session at the same time.
+int main(int argc, char** argv)
+{
+    if (argc != 5)
+    {
+        fprintf(stderr, "Usage: <port> <sender num> <seconds> <packet size>\n");
+        exit(-1);
+    }
+
+    const auto port = static_cast<unsigned short>(std::atoi(argv[1]));
+    const auto senderNum = static_cast<size_t>(std::atoi(argv[2]));
+    const auto seconds = std::atoi(argv[3]);
+    const auto packetSize = static_cast<size_t>(std::atoi(argv[4]));
+
+    std::cout << "sizeof(TcpSession):" << sizeof(TcpSession) << std::endl;
+
+    // open before any thread is created, so all of them are counted.
+#ifdef __linux__
+    const std::vector<std::shared_ptr<PerfCounter>> counters = {
+            std::make_shared<PerfCounter>("task clock(ns)", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK),
+            std::make_shared<PerfCounter>("context switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES),
+            std::make_shared<PerfCounter>("cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES),
+            std::make_shared<PerfCounter>("instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS),
+            std::make_shared<PerfCounter>("cache misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES),
+            std::make_shared<PerfCounter>("L1D read misses", PERF_TYPE_HW_CACHE,
+                                          PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)),
+    };
+#else
+    const std::vector<std::shared_ptr<PerfCounter>> counters;
+#endif
+
+    IoContextThread serverContext(1);
+    serverContext.start(1);
+
+    std::promise<TcpSession::Ptr> sessionPromise;
+    size_t receivedBytes = 0;
+    auto acceptor = TcpAcceptor::Make(serverContext.context(),
+                                      std::make_shared<FixedIoContextProvider>(serverContext.context()),
+                                      asio::ip::tcp::endpoint(asio::ip::tcp::v4(), port));
+    wrapper::TcpSessionAcceptorBuilder builder;
+    builder.WithAcceptor(acceptor)
+            .WithRecvBufferSize(64 * 1024)
+            .WithSessionOptionBuilder([&](wrapper::SessionOptionBuilder& option) {
+                option.AddEstablishHandler([&](const TcpSession::Ptr& session) {
+                          sessionPromise.set_value(session);
+                      })
+                        .WithDataHandler([&](const TcpSession::Ptr&, bsio::base::BasePacketReader& reader) {
+                            receivedBytes += reader.getLeft();
+                            reader.addPos(reader.getLeft());
+                            reader.savePos();
+                        });
+            })
+            .start();
+
+    asio::io_context clientContext;
+    asio::ip::tcp::socket client(clientContext);
+    client.connect(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), port));
+    const auto session = sessionPromise.get_future().get();
+
+    std::atomic<bool> stopped{false};
+    // keep io thread receiving
+    std::thread writer([&]() {
+        std::string data(64 * 1024, 'w');
+        asio::error_code ec;
+        while (!stopped && !ec)
+        {
+            asio::write(client, asio::buffer(data), ec);
+        }
+    });
+    std::atomic<size_t> clientReceivedBytes{0};
+    std::thread reader([&]() {
+        std::string data(64 * 1024, 0);
+        asio::error_code ec;
+        while (!ec)
+        {
+            clientReceivedBytes += client.read_some(asio::buffer(&data[0], data.size()), ec);
+        }
+    });
+
+    // bound in-flight messages of every sender by its send callbacks.
+    struct alignas(64) SenderState {
+        std::atomic<size_t> inflight{0};
+        size_t sent = 0;
+    };
+    std::vector<SenderState> senderStates(senderNum);
+    const auto msg = MakeStringMsg(std::string(packetSize, 's'));
+    std::vector<std::thread> senders;
+    const auto start = Clock::now();
+    for (size_t i = 0; i < senderNum; i++)
+    {
+        senders.emplace_back([&, i]() {
+            auto& state = senderStates[i];
+            while (!stopped)
+            {
+                if (state.inflight.load(std::memory_order_relaxed) >= 1024)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                state.inflight.fetch_add(1, std::memory_order_relaxed);
+                session->send(msg, [&state]() {
+                    state.inflight.fetch_sub(1, std::memory_order_relaxed);
+                });
+                state.sent++;
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    stopped = true;
+    for (auto& sender : senders)
+    {
+        sender.join();
+    }
+    const auto cost = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+
+    writer.join();
+    session->close();
+    reader.join();
+    acceptor->close();
+    // inherited counters only include exited threads
+    serverContext.stop();
+
+    size_t sent = 0;
+    for (const auto& state : senderStates)
+    {
+        sent += state.sent;
+    }
+    std::cout << "cost:" << cost << "ms"
+              << " sends:" << sent
+              << " sends/s:" << (cost > 0 ? sent * 1000 / cost : 0)
+              << " server received:" << receivedBytes / 1024 / 1024 << "MB"
+              << " client received:" << clientReceivedBytes / 1024 / 1024 << "MB"
+              << std::endl;
+    for (const auto& counter : counters)
+    {
+        counter->print();
+    }
+
+    return 0;
+}
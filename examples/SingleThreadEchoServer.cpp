@@ -26,7 +26,8 @@ int main(int argc, char **argv)
 
     auto packetSize = std::atoi(argv[2]);
 
-    WrapperIoContext main(1);
+    // no locks in sessions, all of them are only accessed in main thread.
+    WrapperIoContext main(ASIO_CONCURRENCY_HINT_UNSAFE);
     auto mainIoContextProvider = std::make_shared<FixedIoContextProvider>(main.context());
     TcpAcceptor::Ptr acceptor = TcpAcceptor::Make(
             main.context(),
@@ -0,0 +1,176 @@
+#include <bsio/Bsio.hpp>
+#include <iostream>
+#include <random>
+
+using namespace bsio::net;
+
+using Clock = std::chrono::steady_clock;
+
+static double nsPerOp(Clock::duration cost, size_t num)
+{
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(cost).count()) / num;
+}
+
+static std::vector<std::chrono::milliseconds> makeDelays(size_t num)
+{
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> dist(100, 1100);
+    std::vector<std::chrono::milliseconds> delays;
+    delays.reserve(num);
+    for (size_t i = 0; i < num; i++)
+    {
+        delays.emplace_back(dist(rng));
+    }
+    return delays;
+}
+
+static void report(const char* name, Clock::duration scheduleCost, Clock::duration cancelCost, size_t num, size_t fired)
+{
+    std::cout << name
+              << " schedule:" << nsPerOp(scheduleCost, num) << "ns/op"
+              << " cancel:" << nsPerOp(cancelCost, num / 2) << "ns/op"
+              << " fired:" << fired << "/" << num - num / 2
+              << std::endl;
+}
+
+static void benchSteadyTimer(const std::vector<std::chrono::milliseconds>& delays)
+{
+    asio::io_context ioContext(1);
+    size_t fired = 0;
+    std::vector<std::shared_ptr<asio::steady_timer>> timers;
+    timers.reserve(delays.size());
+
+    auto start = Clock::now();
+    for (const auto& delay : delays)
+    {
+        auto timer = std::make_shared<asio::steady_timer>(ioContext);
+        timer->expires_from_now(delay);
+        timer->async_wait([&fired, timer](const asio::error_code& ec) {
+            if (!ec)
+            {
+                fired++;
+            }
+        });
+        timers.push_back(std::move(timer));
+    }
+    const auto scheduleCost = Clock::now() - start;
+
+    start = Clock::now();
+    for (size_t i = 0; i < timers.size(); i += 2)
+    {
+        timers[i]->cancel();
+    }
+    const auto cancelCost = Clock::now() - start;
+
+    timers.clear();
+    ioContext.run();
+    report("steady_timer  ", scheduleCost, cancelCost, delays.size(), fired);
+}
+
+static void benchWheelRunAfter(const std::vector<std::chrono::milliseconds>& delays)
+{
+    asio::io_context ioContext(1);
+    size_t fired = 0;
+    std::vector<WheelTimer::Ptr> timers;
+    timers.reserve(delays.size());
+
+    auto& wheel = TimerWheel::Get(ioContext);
+    auto start = Clock::now();
+    for (const auto& delay : delays)
+    {
+        timers.push_back(wheel.runAfter(delay, [&fired]() {
+            fired++;
+        }));
+    }
+    const auto scheduleCost = Clock::now() - start;
+
+    start = Clock::now();
+    for (size_t i = 0; i < timers.size(); i += 2)
+    {
+        timers[i]->cancel();
+    }
+    const auto cancelCost = Clock::now() - start;
+
+    timers.clear();
+    ioContext.run();
+    report("wheel runAfter", scheduleCost, cancelCost, delays.size(), fired);
+}
+
+// timer nodes embedded in user objects, such as per session timeouts.
+static void benchWheelIntrusive(const std::vector<std::chrono::milliseconds>& delays)
+{
+    asio::io_context ioContext(1);
+    size_t fired = 0;
+    std::vector<WheelTimer> timers(delays.size());
+    for (auto& timer : timers)
+    {
+        timer.setCallback([&fired]() {
+            fired++;
+        });
+    }
+
+    auto& wheel = TimerWheel::Get(ioContext);
+    auto start = Clock::now();
+    for (size_t i = 0; i < delays.size(); i++)
+    {
+        wheel.schedule(timers[i], delays[i]);
+    }
+    const auto scheduleCost = Clock::now() - start;
+
+    start = Clock::now();
+    for (size_t i = 0; i < timers.size(); i += 2)
+    {
+        timers[i].cancel();
+    }
+    const auto cancelCost = Clock::now() - start;
+
+    ioContext.run();
+    report("wheel node    ", scheduleCost, cancelCost, delays.size(), fired);
+}
+
+static void benchPeriodic(size_t num)
+{
+    asio::io_context ioContext(1);
+    size_t fired = 0;
+    std::vector<WheelTimer::Ptr> timers;
+    timers.reserve(num);
+    for (size_t i = 0; i < num; i++)
+    {
+        timers.push_back(WrapperIoContext::RunEvery(ioContext, std::chrono::milliseconds(100), [&fired]() {
+            fired++;
+        }));
+    }
+
+    WrapperIoContext::RunAfter(ioContext, std::chrono::seconds(1), [&]() {
+        for (const auto& timer : timers)
+        {
+            timer->cancel();
+        }
+    });
+    const auto start = Clock::now();
+    ioContext.run();
+    const auto cost = Clock::now() - start;
+    std::cout << "wheel runEvery timers:" << num
+              << " fired:" << fired
+              << " cost:" << std::chrono::duration_cast<std::chrono::milliseconds>(cost).count() << "ms"
+              << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: <timer num>\n");
+        exit(-1);
+    }
+
+    const auto num = static_cast<size_t>(std::atoi(argv[1]));
+    const auto delays = makeDelays(num);
+
+    benchSteadyTimer(delays);
+    benchWheelRunAfter(delays);
+    benchWheelIntrusive(delays);
+    benchPeriodic(num);
+
+    return 0;
+}
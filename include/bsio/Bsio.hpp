@@ -7,4 +7,5 @@
 #include <bsio/net/TcpAcceptor.hpp>
 #include <bsio/net/TcpConnector.hpp>
 #include <bsio/net/TcpSession.hpp>
+#include <bsio/net/TimerWheel.hpp>
 #include <bsio/net/WrapperIoContext.hpp>
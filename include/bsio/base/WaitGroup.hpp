@@ -52,7 +52,8 @@ public:
         });
     }
 
-private:
+protected:
+    WaitGroup() = default;
     virtual ~WaitGroup() = default;
 
 private:
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace bsio { namespace base {
+
+// compute pool for offloading cpu heavy work off the io threads.
+// every worker owns a deque: it pops its own tasks from the back (LIFO, cache friendly)
+// and steals from the front of other workers' deques when it runs dry.
+class WorkStealingPool
+{
+public:
+    using Ptr = std::shared_ptr<WorkStealingPool>;
+    using Task = std::function<void()>;
+
+    static Ptr Make(size_t workerNum)
+    {
+        return std::make_shared<WorkStealingPool>(workerNum);
+    }
+
+    explicit WorkStealingPool(size_t workerNum)
+    {
+        if (workerNum == 0)
+        {
+            throw std::runtime_error("worker num is zero");
+        }
+        for (size_t i = 0; i < workerNum; i++)
+        {
+            mWorkers.emplace_back(std::make_unique<Worker>());
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    const WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    virtual ~WorkStealingPool() noexcept
+    {
+        stop();
+    }
+
+    void start()
+    {
+        std::lock_guard<std::mutex> lck(mThreadGuard);
+        if (!mThreads.empty())
+        {
+            return;
+        }
+
+        mRunning.store(true);
+        for (size_t i = 0; i < mWorkers.size(); i++)
+        {
+            mThreads.emplace_back(std::thread([this, i]() {
+                workerLoop(i);
+            }));
+        }
+    }
+
+    // stop accepting new tasks, run all queued tasks then join workers.
+    void stop() noexcept
+    {
+        std::lock_guard<std::mutex> lck(mThreadGuard);
+
+        mRunning.store(false);
+        {
+            std::lock_guard<std::mutex> sleepLck(mSleepGuard);
+        }
+        mSleepCond.notify_all();
+
+        for (auto& thread : mThreads)
+        {
+            try
+            {
+                thread.join();
+            }
+            catch (...)
+            {
+            }
+        }
+        mThreads.clear();
+
+        // tasks accepted by submit() are never dropped
+        Task task;
+        for (size_t i = 0; i < mWorkers.size(); i++)
+        {
+            while (popLocal(i, task))
+            {
+                mPendingNum.fetch_sub(1);
+                runTask(task);
+            }
+        }
+    }
+
+    // return false if pool is not running.
+    bool submit(Task task)
+    {
+        // counted before checking mRunning, so stop() either rejects the task,
+        // or its workers see it pending and don't exit before running it.
+        mPendingNum.fetch_add(1);
+        if (!mRunning.load())
+        {
+            mPendingNum.fetch_sub(1);
+            return false;
+        }
+
+        // task submitted by a worker goes to its own deque, otherwise round robin.
+        auto index = tlsWorkerIndex();
+        if (tlsWorkerPool() != this)
+        {
+            index = mPickWorkerIndex.fetch_add(1, std::memory_order_relaxed) % mWorkers.size();
+        }
+        {
+            auto& worker = *mWorkers[index];
+            std::lock_guard<std::mutex> lck(worker.guard);
+            worker.tasks.emplace_back(std::move(task));
+        }
+
+        if (mSleepingNum.load() > 0)
+        {
+            {
+                std::lock_guard<std::mutex> lck(mSleepGuard);
+            }
+            mSleepCond.notify_one();
+        }
+
+        return true;
+    }
+
+    size_t workerNum() const
+    {
+        return mWorkers.size();
+    }
+
+    size_t pendingNum() const
+    {
+        return mPendingNum.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Worker {
+        std::mutex guard;
+        std::deque<Task> tasks;
+    };
+
+    static size_t& tlsWorkerIndex()
+    {
+        static thread_local size_t index = 0;
+        return index;
+    }
+
+    static const WorkStealingPool*& tlsWorkerPool()
+    {
+        static thread_local const WorkStealingPool* pool = nullptr;
+        return pool;
+    }
+
+    bool popLocal(size_t index, Task& task)
+    {
+        auto& worker = *mWorkers[index];
+        std::lock_guard<std::mutex> lck(worker.guard);
+        if (worker.tasks.empty())
+        {
+            return false;
+        }
+        task = std::move(worker.tasks.back());
+        worker.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(size_t thief, Task& task)
+    {
+        for (size_t i = 1; i < mWorkers.size(); i++)
+        {
+            auto& victim = *mWorkers[(thief + i) % mWorkers.size()];
+            std::unique_lock<std::mutex> lck(victim.guard, std::try_to_lock);
+            if (!lck.owns_lock() || victim.tasks.empty())
+            {
+                continue;
+            }
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    static void runTask(Task& task)
+    {
+        try
+        {
+            task();
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "compute task cause exception:" << e.what() << std::endl;
+        }
+        catch (...)
+        {
+        }
+        task = nullptr;
+    }
+
+    void workerLoop(size_t index)
+    {
+        tlsWorkerIndex() = index;
+        tlsWorkerPool() = this;
+
+        Task task;
+        while (true)
+        {
+            if (popLocal(index, task) || steal(index, task))
+            {
+                mPendingNum.fetch_sub(1);
+                runTask(task);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lck(mSleepGuard);
+            mSleepingNum.fetch_add(1);
+            mSleepCond.wait(lck, [this]() {
+                return mPendingNum.load() > 0 || !mRunning.load();
+            });
+            mSleepingNum.fetch_sub(1);
+            if (mPendingNum.load() == 0 && !mRunning.load())
+            {
+                break;
+            }
+        }
+
+        tlsWorkerPool() = nullptr;
+    }
+
+private:
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+    std::vector<std::thread> mThreads;
+    std::mutex mThreadGuard;
+
+    std::mutex mSleepGuard;
+    std::condition_variable mSleepCond;
+    std::atomic_bool mRunning = {false};
+    std::atomic<size_t> mPendingNum = {0};
+    std::atomic<size_t> mSleepingNum = {0};
+    std::atomic<size_t> mPickWorkerIndex = {0};
+};
+
+}}// namespace bsio::base
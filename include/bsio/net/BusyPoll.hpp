@@ -0,0 +1,69 @@
+#pragma once
+
+#include <asio.hpp>
+#include <atomic>
+#include <chrono>
+
+namespace bsio::net {
+
+struct BusyPollOption final {
+    // spin on poll() up to this long without any event before parking in epoll_wait.
+    std::chrono::microseconds maxSpin = std::chrono::microseconds(100);
+    // lower bound of the adaptive spin budget.
+    std::chrono::microseconds minSpin = std::chrono::microseconds(5);
+    // SO_BUSY_POLL(microseconds) for sessions owned by the context, 0 means not set.
+    int socketBusyPoll = 0;
+};
+
+// per io_context state for busy poll, sessions query it when they are created.
+class BusyPollService : public asio::execution_context::service
+{
+public:
+    using key_type = BusyPollService;
+    inline static asio::execution_context::id id;
+
+    explicit BusyPollService(asio::execution_context& context)
+        : asio::execution_context::service(context)
+    {
+    }
+
+    void setSocketBusyPoll(int usec)
+    {
+        mSocketBusyPoll.store(usec, std::memory_order_relaxed);
+    }
+
+    int socketBusyPoll() const
+    {
+        return mSocketBusyPoll.load(std::memory_order_relaxed);
+    }
+
+    static void ApplyToSocket(asio::ip::tcp::socket& socket)
+    {
+#if defined(SO_BUSY_POLL)
+        auto& context = socket.get_executor().context();
+        if (!asio::has_service<BusyPollService>(context))
+        {
+            return;
+        }
+        const auto usec = asio::use_service<BusyPollService>(context).socketBusyPoll();
+        if (usec > 0)
+        {
+            // need CAP_NET_ADMIN when usec is larger than net.core.busy_poll, ignore error.
+            asio::error_code ec;
+            socket.set_option(asio::detail::socket_option::integer<SOL_SOCKET, SO_BUSY_POLL>(usec), ec);
+        }
+#else
+        (void) socket;
+#endif
+    }
+
+private:
+    void shutdown() override
+    {
+    }
+
+private:
+    std::atomic_int mSocketBusyPoll = {0};
+};
+
+}// namespace bsio::net
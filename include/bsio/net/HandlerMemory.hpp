@@ -0,0 +1,159 @@
+#pragma once
+
+#include <asio.hpp>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace bsio::net {
+
+// one memory block reused by a recurring async operation, such as the receive of a session,
+// falls back to heap if the block is in use or too small.
+// not thread safe, the operations using it must be serialized.
+template<size_t BlockSize = 256>
+class HandlerMemory : private asio::noncopyable
+{
+public:
+    void* allocate(size_t size)
+    {
+        if (!mInUse && size <= sizeof(mStorage))
+        {
+            mInUse = true;
+            return &mStorage;
+        }
+        return ::operator new(size);
+    }
+
+    void deallocate(void* pointer)
+    {
+        if (pointer == &mStorage)
+        {
+            mInUse = false;
+        }
+        else
+        {
+            ::operator delete(pointer);
+        }
+    }
+
+private:
+    std::aligned_storage_t<BlockSize, alignof(std::max_align_t)> mStorage;
+    bool mInUse = false;
+};
+
+template<typename T, typename Memory>
+class HandlerAllocator
+{
+public:
+    using value_type = T;
+
+    explicit HandlerAllocator(Memory& memory)
+        : mMemory(memory)
+    {
+    }
+
+    template<typename U>
+    HandlerAllocator(const HandlerAllocator<U, Memory>& other) noexcept
+        : mMemory(other.mMemory)
+    {
+    }
+
+    bool operator==(const HandlerAllocator& other) const noexcept
+    {
+        return &mMemory == &other.mMemory;
+    }
+
+    bool operator!=(const HandlerAllocator& other) const noexcept
+    {
+        return &mMemory != &other.mMemory;
+    }
+
+    T* allocate(size_t n) const
+    {
+        return static_cast<T*>(mMemory.allocate(sizeof(T) * n));
+    }
+
+    void deallocate(T* p, size_t) const
+    {
+        mMemory.deallocate(p);
+    }
+
+private:
+    template<typename, typename>
+    friend class HandlerAllocator;
+
+    Memory& mMemory;
+};
+
+// asio gets the allocator of operation through allocator_type and get_allocator().
+template<typename Handler, typename Memory>
+class AllocHandler
+{
+public:
+    using allocator_type = HandlerAllocator<Handler, Memory>;
+
+    AllocHandler(Memory& memory, Handler handler)
+        : mMemory(memory),
+          mHandler(std::move(handler))
+    {
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return allocator_type(mMemory);
+    }
+
+    template<typename... Args>
+    void operator()(Args&&... args)
+    {
+        mHandler(std::forward<Args>(args)...);
+    }
+
+private:
+    Memory& mMemory;
+    Handler mHandler;
+};
+
+template<typename Memory, typename Handler>
+inline AllocHandler<std::decay_t<Handler>, Memory> MakeAllocHandler(Memory& memory, Handler&& handler)
+{
+    return AllocHandler<std::decay_t<Handler>, Memory>(memory, std::forward<Handler>(handler));
+}
+
+// keeps an existed allocator for the handler wrapping another one, like the strand hop of uring.
+template<typename Handler, typename Allocator>
+class AllocatorHandler
+{
+public:
+    using allocator_type = Allocator;
+
+    AllocatorHandler(const Allocator& allocator, Handler handler)
+        : mAllocator(allocator),
+          mHandler(std::move(handler))
+    {
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return mAllocator;
+    }
+
+    template<typename... Args>
+    void operator()(Args&&... args)
+    {
+        mHandler(std::forward<Args>(args)...);
+    }
+
+private:
+    Allocator mAllocator;
+    Handler mHandler;
+};
+
+template<typename Allocator, typename Handler>
+inline AllocatorHandler<std::decay_t<Handler>, Allocator> MakeAllocatorHandler(const Allocator& allocator, Handler&& handler)
+{
+    return AllocatorHandler<std::decay_t<Handler>, Allocator>(allocator, std::forward<Handler>(handler));
+}
+
+}// namespace bsio::net
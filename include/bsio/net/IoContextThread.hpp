@@ -32,6 +32,10 @@ public:
         {
             throw std::runtime_error("thread num is zero");
         }
+        if (threadNum > 1 && SingleThreadMode::Enabled(context()))
+        {
+            throw std::runtime_error("single thread context can't be run by multi threads");
+        }
         std::lock_guard<std::mutex> lck(mIoThreadGuard);
         if (!mIoThreads.empty())
         {
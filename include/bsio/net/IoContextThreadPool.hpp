@@ -1,5 +1,6 @@
 #pragma once
 
+#include <bsio/base/WorkStealingPool.hpp>
 #include <bsio/net/IoContextProvider.hpp>
 #include <bsio/net/IoContextThread.hpp>
 #include <memory>
@@ -36,6 +37,18 @@ public:
         stop();
     }
 
+    // compute pool's lifecycle is bound to this pool, must be set before start.
+    void setComputePool(base::WorkStealingPool::Ptr computePool)
+    {
+        std::lock_guard<std::mutex> lck(mPoolGuard);
+        mComputePool = std::move(computePool);
+    }
+
+    const base::WorkStealingPool::Ptr& computePool() const
+    {
+        return mComputePool;
+    }
+
     void start(size_t threadNumEveryContext)
     {
         std::lock_guard<std::mutex> lck(mPoolGuard);
@@ -44,12 +57,21 @@ public:
         {
             ioContextThread->start(threadNumEveryContext);
         }
+        if (mComputePool != nullptr)
+        {
+            mComputePool->start();
+        }
     }
 
     void stop()
     {
         std::lock_guard<std::mutex> lck(mPoolGuard);
 
+        // drain compute tasks first, so their results can still be delivered to io contexts.
+        if (mComputePool != nullptr)
+        {
+            mComputePool->stop();
+        }
         for (const auto& ioContextThread : mIoContextThreadList)
         {
             ioContextThread->stop();
@@ -70,6 +92,7 @@ public:
 
 private:
     std::vector<std::shared_ptr<IoContextThread>> mIoContextThreadList;
+    base::WorkStealingPool::Ptr mComputePool;
     std::mutex mPoolGuard;
     std::atomic_long mPickIoContextIndex;
 };
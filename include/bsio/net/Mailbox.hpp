@@ -0,0 +1,160 @@
+#pragma once
+
+#include <asio.hpp>
+#include <atomic>
+#include <bsio/net/WrapperIoContext.hpp>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace bsio::net {
+
+// bounded lock-free multi producer single consumer queue bound to a WrapperIoContext,
+// producers push from any thread, the handler is called in the context's thread.
+// the context is woken up once per batch rather than once per message.
+template<typename T>
+class Mailbox : private asio::noncopyable, public std::enable_shared_from_this<Mailbox<T>>
+{
+public:
+    using Ptr = std::shared_ptr<Mailbox>;
+    using Handler = std::function<void(T&)>;
+
+    // capacity will be rounded up to power of 2.
+    static Ptr Make(WrapperIoContext& wrapperIoContext, size_t capacity, Handler handler)
+    {
+        if (capacity == 0)
+        {
+            throw std::runtime_error("capacity is zero");
+        }
+        if (handler == nullptr)
+        {
+            throw std::runtime_error("handler is nullptr");
+        }
+
+        class make_shared_enabler : public Mailbox
+        {
+        public:
+            make_shared_enabler(asio::io_context& ioContext, size_t capacity, Handler handler)
+                : Mailbox(ioContext, capacity, std::move(handler))
+            {
+            }
+        };
+
+        return std::make_shared<make_shared_enabler>(wrapperIoContext.context(), capacity, std::move(handler));
+    }
+
+    // return false if mailbox is full.
+    bool push(T value)
+    {
+        auto pos = mEnqueuePos.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        while (true)
+        {
+            cell = &mCells[pos & mMask];
+            const auto seq = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = mEnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+
+        // only the first push of a batch wakes up the consumer.
+        if (!mNotified.exchange(true, std::memory_order_acq_rel))
+        {
+            asio::post(mIoContext, [self = this->shared_from_this(), this]() {
+                drain();
+            });
+        }
+        return true;
+    }
+
+    size_t capacity() const
+    {
+        return mCells.size();
+    }
+
+    // number of times the consumer has been woken up.
+    size_t wakeupNum() const
+    {
+        return mWakeupNum.load(std::memory_order_relaxed);
+    }
+
+private:
+    Mailbox(asio::io_context& ioContext, size_t capacity, Handler handler)
+        : mIoContext(ioContext),
+          mHandler(std::move(handler))
+    {
+        size_t size = 1;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        mCells = std::vector<Cell>(size);
+        for (size_t i = 0; i < size; i++)
+        {
+            mCells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        mMask = size - 1;
+    }
+
+    bool pop(T& value)
+    {
+        auto& cell = mCells[mDequeuePos & mMask];
+        const auto seq = cell.sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(mDequeuePos + 1) < 0)
+        {
+            return false;
+        }
+        value = std::move(cell.value);
+        cell.sequence.store(mDequeuePos + mMask + 1, std::memory_order_release);
+        mDequeuePos++;
+        return true;
+    }
+
+    void drain()
+    {
+        mWakeupNum.fetch_add(1, std::memory_order_relaxed);
+        // clear before draining, so pushes after this point will wake up again.
+        mNotified.exchange(false, std::memory_order_acq_rel);
+
+        T value;
+        while (pop(value))
+        {
+            mHandler(value);
+        }
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence{0};
+        T value{};
+    };
+
+    asio::io_context& mIoContext;
+    const Handler mHandler;
+    std::vector<Cell> mCells;
+    size_t mMask = 0;
+
+    alignas(64) std::atomic<size_t> mEnqueuePos{0};
+    alignas(64) std::atomic<bool> mNotified{false};
+    alignas(64) size_t mDequeuePos = 0;
+    std::atomic<size_t> mWakeupNum{0};
+};
+
+}// namespace bsio::net
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <asio.hpp>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace bsio::net {
+
+class TcpSession;
+
+// policies applied when the budget reaches its limit.
+struct MemoryBudgetPolicy {
+    // stop posting receives until usage drops below high water
+    bool pauseRead = false;
+    // send() of sessions drops the message and returns false
+    bool rejectSend = false;
+    // close the session holding the largest send queue
+    bool shedLargest = false;
+};
+
+// accounts bytes held by receive buffers and send queues of sessions sharing the budget,
+// such as all sessions of a process or of a server. a message shared by many sessions is
+// counted once per queue. callbacks are invoked in the thread crossing the threshold.
+class MemoryBudget : private asio::noncopyable
+{
+public:
+    using Ptr = std::shared_ptr<MemoryBudget>;
+
+    enum class Pressure
+    {
+        // below high water
+        Normal,
+        // above high water
+        High,
+        // above limit
+        Critical,
+    };
+
+    using PressureCallback = std::function<void(Pressure, size_t usedBytes)>;
+
+    static Ptr Make(size_t highWater, size_t limit, MemoryBudgetPolicy policy = MemoryBudgetPolicy())
+    {
+        if (highWater > limit)
+        {
+            throw std::runtime_error("high water is greater than limit");
+        }
+
+        class make_shared_enabler : public MemoryBudget
+        {
+        public:
+            make_shared_enabler(size_t highWater, size_t limit, MemoryBudgetPolicy policy)
+                : MemoryBudget(highWater, limit, policy)
+            {
+            }
+        };
+
+        return std::make_shared<make_shared_enabler>(highWater, limit, policy);
+    }
+
+    virtual ~MemoryBudget() = default;
+
+    // must be set before sessions use the budget.
+    void setPressureCallback(PressureCallback callback)
+    {
+        mPressureCallback = std::move(callback);
+    }
+
+    size_t recvBytes() const
+    {
+        return mRecvBytes.load(std::memory_order_relaxed);
+    }
+
+    size_t sendBytes() const
+    {
+        return mSendBytes.load(std::memory_order_relaxed);
+    }
+
+    size_t usedBytes() const
+    {
+        return recvBytes() + sendBytes();
+    }
+
+    size_t sessionNum() const
+    {
+        return mSessionNum.load(std::memory_order_relaxed);
+    }
+
+    Pressure pressure() const
+    {
+        return mPressure.load(std::memory_order_relaxed);
+    }
+
+    size_t highWater() const
+    {
+        return mHighWater;
+    }
+
+    size_t limit() const
+    {
+        return mLimit;
+    }
+
+    const MemoryBudgetPolicy& policy() const
+    {
+        return mPolicy;
+    }
+
+    bool shouldPauseRead() const
+    {
+        return mPolicy.pauseRead && pressure() == Pressure::Critical;
+    }
+
+    bool shouldRejectSend() const
+    {
+        return mPolicy.rejectSend && pressure() == Pressure::Critical;
+    }
+
+private:
+    MemoryBudget(size_t highWater, size_t limit, MemoryBudgetPolicy policy)
+        : mHighWater(highWater),
+          mLimit(limit),
+          mPolicy(policy)
+    {
+    }
+
+    // called by sessions
+
+    void addRecvBytes(size_t bytes)
+    {
+        mRecvBytes.fetch_add(bytes);
+        updatePressure();
+    }
+
+    void subRecvBytes(size_t bytes)
+    {
+        mRecvBytes.fetch_sub(bytes);
+        updatePressure();
+    }
+
+    void addSendBytes(size_t bytes)
+    {
+        mSendBytes.fetch_add(bytes);
+        updatePressure();
+    }
+
+    void subSendBytes(size_t bytes)
+    {
+        mSendBytes.fetch_sub(bytes);
+        updatePressure();
+    }
+
+    // sessions are kept as raw pointers, so the budget never holds their memory, and
+    // they are removed in destructor of session. defined in TcpSession.hpp.
+    inline void track(TcpSession* session);
+    inline void untrack(TcpSession* session);
+
+    void addPausedSession()
+    {
+        mPausedNum.fetch_add(1);
+        // usage may drop before the session was paused
+        if (mPressure.load() == Pressure::Normal)
+        {
+            resumePausedSessions();
+        }
+    }
+
+    void removePausedSession()
+    {
+        mPausedNum.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    Pressure levelOf(size_t usedBytes) const
+    {
+        if (usedBytes >= mLimit)
+        {
+            return Pressure::Critical;
+        }
+        if (usedBytes >= mHighWater)
+        {
+            return Pressure::High;
+        }
+        return Pressure::Normal;
+    }
+
+    // publish the level of current usage. usage may change while a thread is publishing, so the
+    // publisher checks again after its exchange, and the last published level matches usage.
+    // seq_cst orders the check with the updates of counters in other threads.
+    void updatePressure()
+    {
+        for (;;)
+        {
+            const auto usedBytes = mRecvBytes.load() + mSendBytes.load();
+            const auto level = levelOf(usedBytes);
+            auto old = mPressure.load();
+            if (level == old)
+            {
+                return;
+            }
+            if (!mPressure.compare_exchange_strong(old, level))
+            {
+                continue;
+            }
+
+            if (mPressureCallback != nullptr)
+            {
+                mPressureCallback(level, usedBytes);
+            }
+            if (level == Pressure::Critical && mPolicy.shedLargest)
+            {
+                shedLargestSession();
+            }
+            else if (level == Pressure::Normal)
+            {
+                resumePausedSessions();
+            }
+        }
+    }
+
+    inline void shedLargestSession();
+    inline void resumePausedSessions();
+    // the sessions whose reference count is not zero.
+    template<typename Predicate>
+    std::vector<std::shared_ptr<TcpSession>> liveSessions(Predicate&& predicate);
+
+private:
+    const size_t mHighWater;
+    const size_t mLimit;
+    const MemoryBudgetPolicy mPolicy;
+    PressureCallback mPressureCallback;
+
+    std::atomic<size_t> mRecvBytes{0};
+    std::atomic<size_t> mSendBytes{0};
+    std::atomic<size_t> mSessionNum{0};
+    std::atomic<Pressure> mPressure{Pressure::Normal};
+    std::atomic<size_t> mPausedNum{0};
+
+    std::mutex mSessionsGuard;
+    std::vector<TcpSession*> mSessions;
+
+    friend class TcpSession;
+};
+
+}// namespace bsio::net
@@ -1,8 +1,20 @@
+#pragma once
+
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace bsio::net {
 
+// a range of an open file descriptor.
+struct FileRange {
+    int fd = -1;
+    uint64_t offset = 0;
+    size_t size = 0;
+};
+
 class SendableMsg
 {
 public:
@@ -11,6 +23,18 @@ public:
     virtual ~SendableMsg() = default;
     virtual const void *data() = 0;
     virtual size_t size() = 0;
+
+    // the segments of a composite message, nullptr if the message is one span.
+    virtual const std::vector<Ptr> *segments()
+    {
+        return nullptr;
+    }
+
+    // the file range sent by sendfile rather than from memory, nullptr if the message is a buffer.
+    virtual const FileRange *fileRange()
+    {
+        return nullptr;
+    }
 };
 
 class StringSendMsg : public SendableMsg
@@ -59,4 +83,95 @@ static SendableMsg::Ptr MakeStringMsg(std::string &&buffer)
 {
     return std::make_shared<StringSendMsg>(std::move(buffer));
 }
+
+// segments are sent by one gather write, each of them can be shared by other messages,
+// such as a payload broadcast with a head of each recipient. data() is nullptr, size()
+// is the total size of segments.
+class CompositeSendMsg : public SendableMsg
+{
+public:
+    explicit CompositeSendMsg(std::vector<SendableMsg::Ptr> segments)
+        : mSegments(std::move(segments))
+    {
+        for (const auto &segment : mSegments)
+        {
+            mSize += segment->size();
+        }
+    }
+
+    const void *data() override
+    {
+        return nullptr;
+    }
+
+    size_t size() override
+    {
+        return mSize;
+    }
+
+    const std::vector<SendableMsg::Ptr> *segments() override
+    {
+        return &mSegments;
+    }
+
+private:
+    const std::vector<SendableMsg::Ptr> mSegments;
+    size_t mSize = 0;
+};
+
+static SendableMsg::Ptr MakeCompositeMsg(std::vector<SendableMsg::Ptr> segments)
+{
+    return std::make_shared<CompositeSendMsg>(std::move(segments));
+}
+
+// the bytes of a file range are sent from page cache by sendfile, they are never copied
+// into user space on linux. owner keeps the descriptor open until the message is sent.
+class FileSendMsg : public SendableMsg
+{
+public:
+    FileSendMsg(std::shared_ptr<const void> owner, FileRange range)
+        : mOwner(std::move(owner)),
+          mRange(range)
+    {
+    }
+
+    const void *data() override
+    {
+        return nullptr;
+    }
+
+    size_t size() override
+    {
+        return mRange.size;
+    }
+
+    const FileRange *fileRange() override
+    {
+        return &mRange;
+    }
+
+private:
+    const std::shared_ptr<const void> mOwner;
+    const FileRange mRange;
+};
+
+static SendableMsg::Ptr MakeFileMsg(std::shared_ptr<const void> owner, FileRange range)
+{
+    return std::make_shared<FileSendMsg>(std::move(owner), range);
+}
+
+// the bytes held in memory, file ranges are excluded.
+static size_t BufferedSize(const SendableMsg::Ptr &msg)
+{
+    if (const auto segments = msg->segments())
+    {
+        size_t size = 0;
+        for (const auto &segment : *segments)
+        {
+            size += BufferedSize(segment);
+        }
+        return size;
+    }
+    return msg->fileRange() != nullptr ? 0 : msg->size();
+}
 }// namespace bsio::net
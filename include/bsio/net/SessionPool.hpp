@@ -0,0 +1,222 @@
+#pragma once
+
+#include <asio.hpp>
+#include <asio/detail/conditionally_enabled_mutex.hpp>
+#include <bsio/net/SingleThreadMode.hpp>
+#include <memory>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+namespace bsio::net {
+
+// per io_context free lists of session memory, user data and receive buffers, so connection churn
+// reuses them instead of heap. objects can be returned from any thread when the last
+// reference drops, and they must be released before the io_context is destroyed.
+class SessionPool : public asio::execution_context::service
+{
+public:
+    using key_type = SessionPool;
+    inline static asio::execution_context::id id;
+
+    static constexpr size_t DefaultMaxPooledNum = 1024;
+    // a grown receive buffer is freed rather than pooled, so the pool never pins the memory of
+    // large buffers, which is not accounted by memory budget after the session is destroyed.
+    static constexpr size_t MaxPooledBufferCapacity = 4 * 1024;
+
+    explicit SessionPool(asio::execution_context& context)
+        : asio::execution_context::service(context),
+          mGuard(!SingleThreadMode::Enabled(context))
+    {
+    }
+
+    ~SessionPool() override
+    {
+        for (const auto& list : mBlockLists)
+        {
+            for (const auto& block : list.blocks)
+            {
+                ::operator delete(block, std::align_val_t(list.align));
+            }
+        }
+    }
+
+    static SessionPool& Get(asio::execution_context& context)
+    {
+        return asio::use_service<SessionPool>(context);
+    }
+
+    // blocks and buffers beyond the limit are freed.
+    void setMaxPooledNum(size_t maxPooledNum)
+    {
+        Lock lck(mGuard);
+        mMaxPooledNum = maxPooledNum;
+    }
+
+    // blocks are pooled by size, there are only a few sizes: sessions and types of user data.
+    void* allocate(size_t size, size_t align)
+    {
+        {
+            Lock lck(mGuard);
+            auto& blocks = blockList(size, align).blocks;
+            if (!blocks.empty())
+            {
+                auto block = blocks.back();
+                blocks.pop_back();
+                return block;
+            }
+        }
+        return ::operator new(size, std::align_val_t(align));
+    }
+
+    void deallocate(void* block, size_t size, size_t align)
+    {
+        {
+            Lock lck(mGuard);
+            auto& blocks = blockList(size, align).blocks;
+            if (blocks.size() < mMaxPooledNum)
+            {
+                blocks.push_back(block);
+                return;
+            }
+        }
+        ::operator delete(block, std::align_val_t(align));
+    }
+
+    // buffers are pooled by maxSize, and only the ones not larger than MaxPooledBufferCapacity.
+    std::unique_ptr<asio::streambuf> acquireBuffer(size_t maxSize)
+    {
+        {
+            Lock lck(mGuard);
+            const auto it = mBuffers.find(maxSize);
+            if (it != mBuffers.end() && !it->second.empty())
+            {
+                auto buffer = std::move(it->second.back());
+                it->second.pop_back();
+                mBufferNum--;
+                return buffer;
+            }
+        }
+        return std::make_unique<asio::streambuf>(maxSize);
+    }
+
+    void releaseBuffer(std::unique_ptr<asio::streambuf> buffer)
+    {
+        if (buffer == nullptr || buffer->capacity() > MaxPooledBufferCapacity)
+        {
+            return;
+        }
+        buffer->consume(buffer->size());
+
+        Lock lck(mGuard);
+        if (mBufferNum < mMaxPooledNum)
+        {
+            mBuffers[buffer->max_size()].push_back(std::move(buffer));
+            mBufferNum++;
+        }
+        else
+        {
+            // free it outside the lock
+            lck.unlock();
+            buffer.reset();
+        }
+    }
+
+    size_t pooledBlockNum() const
+    {
+        Lock lck(mGuard);
+        size_t num = 0;
+        for (const auto& list : mBlockLists)
+        {
+            num += list.blocks.size();
+        }
+        return num;
+    }
+
+    size_t pooledBufferNum() const
+    {
+        Lock lck(mGuard);
+        return mBufferNum;
+    }
+
+private:
+    using Lock = asio::detail::conditionally_enabled_mutex::scoped_lock;
+
+    struct BlockList {
+        size_t size;
+        size_t align;
+        std::vector<void*> blocks;
+    };
+
+    BlockList& blockList(size_t size, size_t align)
+    {
+        for (auto& list : mBlockLists)
+        {
+            if (list.size == size && list.align == align)
+            {
+                return list;
+            }
+        }
+        return mBlockLists.emplace_back(BlockList{size, align, {}});
+    }
+
+    // sessions may be released in the shutdown of other services, so lists are freed in destructor.
+    void shutdown() override
+    {
+    }
+
+private:
+    mutable asio::detail::conditionally_enabled_mutex mGuard;
+    size_t mMaxPooledNum = DefaultMaxPooledNum;
+    std::vector<BlockList> mBlockLists;
+    // keyed by max size of buffers
+    std::unordered_map<size_t, std::vector<std::unique_ptr<asio::streambuf>>> mBuffers;
+    size_t mBufferNum = 0;
+};
+
+// used by std::allocate_shared, so the control block and the object share one pooled block.
+template<typename T>
+class SessionPoolAllocator
+{
+public:
+    using value_type = T;
+
+    explicit SessionPoolAllocator(SessionPool& pool) noexcept
+        : mPool(&pool)
+    {
+    }
+
+    template<typename U>
+    SessionPoolAllocator(const SessionPoolAllocator<U>& other) noexcept
+        : mPool(other.mPool)
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(mPool->allocate(sizeof(T) * n, alignof(T)));
+    }
+
+    void deallocate(T* p, size_t n) noexcept
+    {
+        mPool->deallocate(p, sizeof(T) * n, alignof(T));
+    }
+
+    bool operator==(const SessionPoolAllocator& other) const noexcept
+    {
+        return mPool == other.mPool;
+    }
+
+    bool operator!=(const SessionPoolAllocator& other) const noexcept
+    {
+        return mPool != other.mPool;
+    }
+
+private:
+    template<typename>
+    friend class SessionPoolAllocator;
+
+    SessionPool* mPool;
+};
+
+}// namespace bsio::net
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <array>
+#include <asio.hpp>
+#include <atomic>
+#include <bsio/net/TcpSession.hpp>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace bsio::net {
+
+// sessions of all io_contexts indexed by 64-bit id, the id is made of
+// generation(32 bits) | slot index(20 bits) | shard(12 bits), so lookup is an array access.
+// add and remove lock one shard, lookup and iteration take no lock of registry, the slot is
+// validated by id before and after loading the session. loading the session is not lock-free:
+// atomic functions of shared_ptr lock a spinlock picked by the address of slot in libstdc++,
+// which is held only for the copy of the pointer.
+class SessionRegistry : private asio::noncopyable, public std::enable_shared_from_this<SessionRegistry>
+{
+public:
+    using Ptr = std::shared_ptr<SessionRegistry>;
+    using SessionId = uint64_t;
+
+    static constexpr size_t MaxShardNum = 1 << 12;
+
+    static Ptr Make(size_t shardNum = 16)
+    {
+        if (shardNum == 0 || shardNum > MaxShardNum || (shardNum & (shardNum - 1)) != 0)
+        {
+            throw std::runtime_error("shard num must be power of two and not greater than 4096");
+        }
+
+        class make_shared_enabler : public SessionRegistry
+        {
+        public:
+            explicit make_shared_enabler(size_t shardNum)
+                : SessionRegistry(shardNum)
+            {
+            }
+        };
+
+        return std::make_shared<make_shared_enabler>(shardNum);
+    }
+
+    // use as establish handler of session builder, session is registered when established
+    // and removed after its ClosedHandler.
+    TcpSessionEstablishHandler establishHandler()
+    {
+        return [weak = weak_from_this()](const TcpSession::Ptr& session) {
+            if (auto registry = weak.lock())
+            {
+                const auto id = registry->add(session);
+                session->appendClosedHandler([weak, id](const TcpSession::Ptr&) {
+                    if (auto registry = weak.lock())
+                    {
+                        registry->remove(id);
+                    }
+                });
+            }
+        };
+    }
+
+    SessionId add(const TcpSession::Ptr& session)
+    {
+        auto& shard = mShards[mNextShard.fetch_add(1, std::memory_order_relaxed) & (mShards.size() - 1)];
+        const auto shardIndex = static_cast<SessionId>(&shard - mShards.data());
+
+        SessionId id = 0;
+        {
+            std::lock_guard<std::mutex> lck(shard.guard);
+            uint32_t index = 0;
+            if (!shard.freeIndexes.empty())
+            {
+                index = shard.freeIndexes.back();
+                shard.freeIndexes.pop_back();
+            }
+            else
+            {
+                if (shard.slotNum.load(std::memory_order_relaxed) == MaxSlotNum)
+                {
+                    throw std::runtime_error("too many sessions in registry");
+                }
+                index = shard.slotNum.load(std::memory_order_relaxed);
+                auto& segment = shard.segments[index / SegmentSize];
+                if (segment.load(std::memory_order_relaxed) == nullptr)
+                {
+                    segment.store(new Slot[SegmentSize], std::memory_order_release);
+                }
+                shard.slotNum.store(index + 1, std::memory_order_release);
+            }
+
+            auto& slot = shard.segments[index / SegmentSize].load(std::memory_order_relaxed)[index % SegmentSize];
+            id = (static_cast<SessionId>(slot.generation) << 32) |
+                 (static_cast<SessionId>(index) << ShardBits) |
+                 shardIndex;
+            // published with the slot
+            session->setId(id);
+            std::atomic_store_explicit(&slot.session, session, std::memory_order_release);
+            slot.id.store(id, std::memory_order_release);
+        }
+        mSize.fetch_add(1, std::memory_order_relaxed);
+
+        return id;
+    }
+
+    bool remove(SessionId id)
+    {
+        if ((id & ShardMask) >= mShards.size())
+        {
+            return false;
+        }
+        auto& shard = mShards[id & ShardMask];
+        TcpSession::Ptr session;
+        {
+            std::lock_guard<std::mutex> lck(shard.guard);
+            const auto slot = findSlot(shard, id);
+            if (slot == nullptr || slot->id.load(std::memory_order_relaxed) != id)
+            {
+                return false;
+            }
+            slot->id.store(0, std::memory_order_release);
+            session = std::atomic_exchange_explicit(&slot->session, TcpSession::Ptr(), std::memory_order_acq_rel);
+            // id 0 is never used
+            if (++slot->generation == 0)
+            {
+                slot->generation = 1;
+            }
+            shard.freeIndexes.push_back(static_cast<uint32_t>((id >> ShardBits) & IndexMask));
+        }
+        mSize.fetch_sub(1, std::memory_order_relaxed);
+        // the session may be destroyed here, outside the lock
+
+        return true;
+    }
+
+    TcpSession::Ptr find(SessionId id) const
+    {
+        if ((id & ShardMask) >= mShards.size())
+        {
+            return nullptr;
+        }
+        const auto slot = findSlot(mShards[id & ShardMask], id);
+        if (slot == nullptr || slot->id.load(std::memory_order_acquire) != id)
+        {
+            return nullptr;
+        }
+        auto session = std::atomic_load_explicit(&slot->session, std::memory_order_acquire);
+        // the slot is reused by other session during loading
+        if (slot->id.load(std::memory_order_acquire) != id)
+        {
+            return nullptr;
+        }
+        return session;
+    }
+
+    // return false if the session is not found.
+    bool sendTo(SessionId id, SendableMsg::Ptr msg, TcpSession::SendCompletedCallback callback = nullptr) const
+    {
+        if (const auto session = find(id))
+        {
+            session->send(std::move(msg), std::move(callback));
+            return true;
+        }
+        return false;
+    }
+
+    // call f(id, session) for every session, sessions added or removed during iteration may be missed.
+    template<typename F>
+    void forEach(F&& f) const
+    {
+        for (const auto& shard : mShards)
+        {
+            const auto slotNum = shard.slotNum.load(std::memory_order_acquire);
+            for (uint32_t index = 0; index < slotNum; index++)
+            {
+                const auto& slot = shard.segments[index / SegmentSize].load(std::memory_order_acquire)[index % SegmentSize];
+                const auto id = slot.id.load(std::memory_order_acquire);
+                if (id == 0)
+                {
+                    continue;
+                }
+                auto session = std::atomic_load_explicit(&slot.session, std::memory_order_acquire);
+                if (session != nullptr && slot.id.load(std::memory_order_acquire) == id)
+                {
+                    f(id, session);
+                }
+            }
+        }
+    }
+
+    std::vector<TcpSession::Ptr> snapshot() const
+    {
+        std::vector<TcpSession::Ptr> sessions;
+        sessions.reserve(size());
+        forEach([&](SessionId, const TcpSession::Ptr& session) {
+            sessions.push_back(session);
+        });
+        return sessions;
+    }
+
+    void broadcast(const SendableMsg::Ptr& msg) const
+    {
+        forEach([&](SessionId, const TcpSession::Ptr& session) {
+            session->send(msg);
+        });
+    }
+
+    size_t size() const
+    {
+        return mSize.load(std::memory_order_relaxed);
+    }
+
+    virtual ~SessionRegistry()
+    {
+        for (auto& shard : mShards)
+        {
+            for (auto& segment : shard.segments)
+            {
+                delete[] segment.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    static constexpr size_t ShardBits = 12;
+    static constexpr SessionId ShardMask = (1 << ShardBits) - 1;
+    static constexpr size_t IndexBits = 20;
+    static constexpr SessionId IndexMask = (1 << IndexBits) - 1;
+    static constexpr uint32_t SegmentSize = 4096;
+    static constexpr uint32_t MaxSlotNum = 1 << IndexBits;
+
+    struct Slot {
+        std::atomic<SessionId> id{0};
+        // accessed by atomic functions of shared_ptr, see the comment of class
+        TcpSession::Ptr session;
+        // guarded by shard lock
+        uint32_t generation = 1;
+    };
+
+    // segments are never moved or freed before registry, so readers don't need lock.
+    struct alignas(64) Shard {
+        std::mutex guard;
+        std::atomic<uint32_t> slotNum{0};
+        std::array<std::atomic<Slot*>, MaxSlotNum / SegmentSize> segments{};
+        std::vector<uint32_t> freeIndexes;
+    };
+
+    explicit SessionRegistry(size_t shardNum)
+        : mShards(shardNum)
+    {
+    }
+
+    static Slot* findSlot(const Shard& shard, SessionId id)
+    {
+        const auto index = static_cast<uint32_t>((id >> ShardBits) & IndexMask);
+        if (id == 0 || index >= shard.slotNum.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+        return &shard.segments[index / SegmentSize].load(std::memory_order_acquire)[index % SegmentSize];
+    }
+
+private:
+    std::vector<Shard> mShards;
+    std::atomic<size_t> mNextShard{0};
+    std::atomic<size_t> mSize{0};
+};
+
+}// namespace bsio::net
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <asio.hpp>
+#include <cassert>
+
+namespace bsio::net {
+
+// marks an io_context that is run by one thread and never accessed from other threads,
+// such as created with ASIO_CONCURRENCY_HINT_UNSAFE, sessions and timers of it skip locks
+// and dispatch, and assert in debug build if they are accessed off-thread.
+class SingleThreadMode : public asio::execution_context::service
+{
+public:
+    using key_type = SingleThreadMode;
+    inline static asio::execution_context::id id;
+
+    explicit SingleThreadMode(asio::execution_context& context)
+        : asio::execution_context::service(context)
+    {
+    }
+
+    // must be called before any session or timer is created in the context.
+    static void Enable(asio::execution_context& context)
+    {
+        asio::use_service<SingleThreadMode>(context);
+    }
+
+    static bool Enabled(asio::execution_context& context)
+    {
+        return asio::has_service<SingleThreadMode>(context);
+    }
+
+    static bool IsUnsafeConcurrencyHint(int concurrencyHint)
+    {
+        return concurrencyHint == ASIO_CONCURRENCY_HINT_UNSAFE ||
+               concurrencyHint == ASIO_CONCURRENCY_HINT_UNSAFE_IO;
+    }
+
+private:
+    void shutdown() override
+    {
+    }
+};
+
+}// namespace bsio::net
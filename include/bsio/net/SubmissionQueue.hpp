@@ -0,0 +1,159 @@
+#pragma once
+
+#include <asio.hpp>
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+
+namespace bsio::net {
+
+// per io_context queue for cross thread tasks, tasks are pushed lock-free and the context is
+// only woken up when the queue turns from empty to non-empty, then all tasks run as a batch.
+class SubmissionQueue : public asio::execution_context::service
+{
+public:
+    using key_type = SubmissionQueue;
+    inline static asio::execution_context::id id;
+
+    using Task = std::function<void(void)>;
+
+    explicit SubmissionQueue(asio::execution_context& context)
+        : asio::execution_context::service(context),
+          mIoContext(static_cast<asio::io_context&>(context))
+    {
+    }
+
+    static SubmissionQueue& Get(asio::execution_context& context)
+    {
+        return asio::use_service<SubmissionQueue>(context);
+    }
+
+    // can be called in any thread, tasks are executed in submission order if context is run by one thread.
+    // the task may be move-only, and it's stored in the node without another allocation.
+    template<typename F>
+    void submit(F&& task)
+    {
+        Node* node = new TaskNode<std::decay_t<F>>(std::forward<F>(task));
+        // the node may be drained as soon as it's published, so don't touch it after that.
+        auto head = mHead.load(std::memory_order_relaxed);
+        do
+        {
+            node->next = head;
+        } while (!mHead.compare_exchange_weak(head, node,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed));
+
+        if (head == nullptr)
+        {
+            asio::post(mIoContext, [this]() {
+                drain();
+            });
+        }
+    }
+
+    bool runningInThisThread() const
+    {
+        return mIoContext.get_executor().running_in_this_thread();
+    }
+
+    // run task directly if in context's thread, otherwise submit it.
+    template<typename F>
+    void dispatch(F&& task)
+    {
+        if (runningInThisThread())
+        {
+            task();
+        }
+        else
+        {
+            submit(std::forward<F>(task));
+        }
+    }
+
+private:
+    struct Node {
+        virtual ~Node() = default;
+        virtual void run() = 0;
+
+        Node* next = nullptr;
+    };
+
+    template<typename F>
+    struct TaskNode : Node {
+        explicit TaskNode(F&& f)
+            : task(std::move(f))
+        {
+        }
+
+        explicit TaskNode(const F& f)
+            : task(f)
+        {
+        }
+
+        void run() override
+        {
+            task();
+        }
+
+        F task;
+    };
+
+    static Node* reverse(Node* head)
+    {
+        Node* prev = nullptr;
+        while (head != nullptr)
+        {
+            auto next = head->next;
+            head->next = prev;
+            prev = head;
+            head = next;
+        }
+        return prev;
+    }
+
+    void drain()
+    {
+        // the stack is LIFO, reverse it to keep submission order.
+        auto node = reverse(mHead.exchange(nullptr, std::memory_order_acquire));
+        while (node != nullptr)
+        {
+            auto next = node->next;
+            try
+            {
+                node->run();
+            }
+            catch (const std::exception& e)
+            {
+                std::cout << "submitted task cause exception:" << e.what() << std::endl;
+            }
+            catch (...)
+            {
+            }
+            delete node;
+            node = next;
+        }
+    }
+
+    static void deleteList(Node* node)
+    {
+        while (node != nullptr)
+        {
+            auto next = node->next;
+            delete node;
+            node = next;
+        }
+    }
+
+    void shutdown() override
+    {
+        deleteList(mHead.exchange(nullptr, std::memory_order_acquire));
+    }
+
+private:
+    asio::io_context& mIoContext;
+    std::atomic<Node*> mHead{nullptr};
+};
+
+}// namespace bsio::net
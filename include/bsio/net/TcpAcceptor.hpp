@@ -2,12 +2,18 @@
 
 #include <asio/basic_socket_acceptor.hpp>
 #include <bsio/net/Functor.hpp>
+#include <bsio/net/HandlerMemory.hpp>
 #include <bsio/net/IoContextProvider.hpp>
-#include <bsio/net/SharedSocket.hpp>
+#include <bsio/net/SubmissionQueue.hpp>
+#include <bsio/net/uring/Config.hpp>
 #include <functional>
 #include <memory>
 #include <utility>
 
+#ifdef BSIO_HAS_IO_URING
+#include <bsio/net/uring/UringService.hpp>
+#endif
+
 namespace bsio::net {
 
 class TcpAcceptor : private asio::noncopyable,
@@ -37,55 +43,126 @@ public:
 
     virtual ~TcpAcceptor()
     {
-        close();
+        doClose();
     }
 
-    void startAccept(const SocketEstablishHandler& callback)
+    void startAccept(SocketEstablishHandler callback)
     {
-        doAccept(callback);
+        mEstablishHandler = std::move(callback);
+        doAccept();
     }
 
+    // the acceptor is closed in listen context's thread, so it's not raced with pending accept.
     void close()
     {
-        mAcceptor.close();
+        asio::dispatch(mAcceptor.get_executor(), [self = shared_from_this(), this]() {
+            doClose();
+        });
     }
 
 private:
+    void doClose()
+    {
+#ifdef BSIO_HAS_IO_URING
+        if (mAcceptor.is_open())
+        {
+            if (auto uring = uring::UringService::Get(mAcceptor.get_executor().context()))
+            {
+                uring->cancel(mAcceptor.native_handle());
+            }
+        }
+#endif
+        asio::error_code ec;
+        mAcceptor.close(ec);
+    }
+
     TcpAcceptor(
             asio::io_context& listenContext,
             IoContextProvider::Ptr ioContextProvider,
             const asio::ip::tcp::endpoint& endpoint)
         : mIoContextProvider(std::move(ioContextProvider)),
-          mAcceptor(listenContext, endpoint)
+          mAcceptor(listenContext, endpoint),
+          mProtocol(endpoint.protocol())
     {
         mAcceptor.set_option(asio::socket_base::reuse_address(true));
     }
 
-    void doAccept(const SocketEstablishHandler& callback)
+    void doAccept()
     {
         if (!mAcceptor.is_open())
         {
             return;
         }
 
-        auto& ioContext = mIoContextProvider->pickIoContext();
-        auto sharedSocket = SharedSocket::Make(asio::ip::tcp::socket(ioContext), ioContext);
+#ifdef BSIO_HAS_IO_URING
+        if (auto uring = uring::UringService::Get(mAcceptor.get_executor().context()))
+        {
+            doUringAccept(*uring);
+            return;
+        }
+#endif
+
+        // the socket is accepted into the picked context directly and moved to the handler.
+        const asio::executor executor = mIoContextProvider->pickIoContext().get_executor();
         mAcceptor.async_accept(
-                sharedSocket->socket(),
-                [self = shared_from_this(), this, callback, sharedSocket](std::error_code ec) mutable {
-                    if (!ec)
+                executor,
+                MakeAllocHandler(mAcceptHandlerMemory,
+                                 [self = shared_from_this(), this](std::error_code ec, asio::ip::tcp::socket socket) {
+                                     if (!ec)
+                                     {
+                                         handOff(std::move(socket));
+                                     }
+                                     doAccept();
+                                 }));
+    }
+
+    // run establish handler in the context of socket.
+    void handOff(asio::ip::tcp::socket socket)
+    {
+        auto& submissionQueue = SubmissionQueue::Get(socket.get_executor().context());
+        submissionQueue.submit([self = shared_from_this(), this, socket = std::move(socket)]() mutable {
+            mEstablishHandler(std::move(socket));
+        });
+    }
+
+#ifdef BSIO_HAS_IO_URING
+    // one multishot accept produces all connections.
+    void doUringAccept(uring::UringService& uring)
+    {
+        uring.asyncAcceptMultishot(
+                mAcceptor.native_handle(),
+                [self = shared_from_this(), this](std::error_code ec, int fd) {
+                    if (ec)
+                    {
+                        // the error finishes the multishot accept, start another one unless
+                        // it's cancelled or the acceptor is closed.
+                        if (ec != asio::error::operation_aborted)
+                        {
+                            doAccept();
+                        }
+                        return;
+                    }
+
+                    auto& ioContext = mIoContextProvider->pickIoContext();
+                    try
+                    {
+                        handOff(asio::ip::tcp::socket(ioContext, mProtocol, fd));
+                    }
+                    catch (...)
                     {
-                        sharedSocket->context().post([=]() {
-                            callback(std::move(sharedSocket->socket()));
-                        });
+                        ::close(fd);
                     }
-                    doAccept(callback);
                 });
     }
+#endif
 
 private:
     IoContextProvider::Ptr mIoContextProvider;
     asio::ip::tcp::acceptor mAcceptor;
+    asio::ip::tcp mProtocol;
+    SocketEstablishHandler mEstablishHandler;
+    // only one accept is pending at a time
+    HandlerMemory<256> mAcceptHandlerMemory;
 };
 
 }// namespace bsio::net
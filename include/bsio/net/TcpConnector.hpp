@@ -3,6 +3,7 @@
 #include <bsio/net/Functor.hpp>
 #include <bsio/net/IoContextProvider.hpp>
 #include <bsio/net/SharedSocket.hpp>
+#include <bsio/net/TimerWheel.hpp>
 #include <functional>
 #include <memory>
 
@@ -63,7 +64,7 @@ private:
         auto sharedSocket = SharedSocket::Make(
                 asio::ip::tcp::socket(ioContext),
                 ioContext);
-        auto timeoutTimer = WrapperIoContext::RunAfter(ioContext, timeout, [=]() {
+        auto timeoutTimer = TimerWheel::Get(ioContext).runAfter(timeout, [=]() {
             failedCallback();
         });
 
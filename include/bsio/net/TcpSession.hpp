@@ -2,20 +2,96 @@
 
 #include <algorithm>
 #include <asio.hpp>
+#include <asio/detail/conditionally_enabled_mutex.hpp>
 #include <asio/socket_base.hpp>
 #include <bsio/base/Packet.hpp>
+#include <bsio/base/WorkStealingPool.hpp>
+#include <bsio/net/BusyPoll.hpp>
+#include <bsio/net/HandlerMemory.hpp>
+#include <bsio/net/MemoryBudget.hpp>
 #include <bsio/net/SendableMsg.hpp>
+#include <bsio/net/SessionPool.hpp>
+#include <bsio/net/SingleThreadMode.hpp>
+#include <bsio/net/SubmissionQueue.hpp>
+#include <bsio/net/TimerWheel.hpp>
+#include <bsio/net/uring/Config.hpp>
 #include <cmath>
 #include <deque>
+#include <exception>
 #include <functional>
 #include <iostream>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <type_traits>
+
+#ifdef BSIO_HAS_IO_URING
+#include <bsio/net/uring/UringService.hpp>
+#endif
+
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#elif defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace bsio::net {
 
+#if !defined(__linux__)
+namespace internal {
+
+// reads at the offset without moving the file position, the descriptor may be shared.
+inline int64_t ReadFileAt(int fd, void* buffer, size_t len, uint64_t offset)
+{
+#ifdef _WIN32
+    OVERLAPPED overlapped{};
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD readBytes = 0;
+    if (!::ReadFile(reinterpret_cast<HANDLE>(::_get_osfhandle(fd)), buffer, static_cast<DWORD>(len), &readBytes, &overlapped))
+    {
+        return ::GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+    }
+    return readBytes;
+#else
+    return ::pread(fd, buffer, len, static_cast<off_t>(offset));
+#endif
+}
+
+}// namespace internal
+#endif
+
 const size_t MinReceivePrepareSize = 1024;
 
+enum class CloseReason
+{
+    None,
+    PeerClosed,
+    Error,
+    Local,
+    IdleTimeout,
+    ReadTimeout,
+    WriteTimeout,
+    MemoryPressure,
+};
+
+// zero means disabled.
+struct TcpSessionTimeout {
+    // no bytes received and no write completed
+    std::chrono::nanoseconds idle = std::chrono::nanoseconds::zero();
+    // no bytes received
+    std::chrono::nanoseconds read = std::chrono::nanoseconds::zero();
+    // pending write makes no progress
+    std::chrono::nanoseconds write = std::chrono::nanoseconds::zero();
+
+    bool enabled() const
+    {
+        return idle.count() > 0 || read.count() > 0 || write.count() > 0;
+    }
+};
+
 class TcpSession : private asio::noncopyable, public std::enable_shared_from_this<TcpSession>
 {
 public:
@@ -25,12 +101,16 @@ public:
     using EofHandler = std::function<void(Ptr)>;
     using SendCompletedCallback = std::function<void()>;
     using HighWaterCallback = std::function<void()>;
+    using UserDataInit = std::function<void(TcpSession&)>;
 
+    // if useStrand is true, all completions of session are serialized by a strand,
+    // so the session is safe in io_context run by multi threads.
     static Ptr Make(asio::ip::tcp::socket socket,
                     size_t maxRecvBufferSize,
                     DataHandler dataHandler,
                     ClosedHandler closedHandler,
-                    EofHandler eofHandler)
+                    EofHandler eofHandler,
+                    bool useStrand = false)
     {
         if (maxRecvBufferSize == 0)
         {
@@ -48,24 +128,50 @@ public:
                                 size_t maxRecvBufferSize,
                                 DataHandler dataHandler,
                                 ClosedHandler closedHandler,
-                                EofHandler eofHandler)
+                                EofHandler eofHandler,
+                                bool useStrand)
                 : TcpSession(
                           std::move(socket),
                           maxRecvBufferSize,
                           std::move(dataHandler),
                           std::move(closedHandler),
-                          std::move(eofHandler))
+                          std::move(eofHandler),
+                          useStrand)
             {
             }
         };
 
-        auto session = std::make_shared<make_shared_enabler>(
-                std::move(socket), maxRecvBufferSize, std::move(dataHandler), std::move(closedHandler), std::move(eofHandler));
+        // memory of session is recycled by the pool of its io_context.
+        auto& pool = SessionPool::Get(socket.get_executor().context());
+        auto session = std::allocate_shared<make_shared_enabler>(
+                SessionPoolAllocator<make_shared_enabler>(pool),
+                std::move(socket), maxRecvBufferSize, std::move(dataHandler), std::move(closedHandler), std::move(eofHandler),
+                useStrand);
 
         return std::static_pointer_cast<TcpSession>(session);
     }
 
-    virtual ~TcpSession() = default;
+    virtual ~TcpSession()
+    {
+        resetUserData();
+        // release accounted bytes before the budget
+        mPendingSendMsgList.clear();
+        mSendingMsgList.clear();
+        mSessionPool.releaseBuffer(std::move(mReceiveBuffer));
+        if (mMemoryBudget != nullptr)
+        {
+            updateRecvBudget();
+            if (mBudgetPaused.load(std::memory_order_relaxed))
+            {
+                mMemoryBudget->removePausedSession();
+            }
+            mMemoryBudget->untrack(this);
+        }
+        if (mTimerWheel != nullptr)
+        {
+            mTimerWheel->releaseCoarseClock();
+        }
+    }
 
     void startRecv()
     {
@@ -76,46 +182,37 @@ public:
 
     auto runAfter(std::chrono::nanoseconds timeout, std::function<void(void)> callback)
     {
-#if ASIO_VERSION >= 101300
-        auto timer = std::make_shared<asio::steady_timer>(mSocket.get_executor());
-#else
-        auto timer = std::make_shared<asio::steady_timer>(mSocket.get_io_context());
-#endif
-        timer->expires_from_now(timeout);
-        timer->async_wait([callback = std::move(callback), timer](const asio::error_code& ec) {
-            if (!ec)
-            {
-                callback();
-            }
-        });
-        return timer;
+        return TimerWheel::Get(mSocket.get_executor().context()).runAfter(timeout, std::move(callback));
+    }
+
+    auto runEvery(std::chrono::nanoseconds period, std::function<void(void)> callback)
+    {
+        return TimerWheel::Get(mSocket.get_executor().context()).runEvery(period, std::move(callback));
     }
 
     void dispatch(std::function<void(void)> functor)
     {
-        asio::dispatch(mSocket.get_executor(), std::move(functor));
+        runInLoop(std::move(functor));
     }
 
     void setHighWater(HighWaterCallback callback, size_t highWater)
     {
-        asio::dispatch(mSocket.get_executor(),
-                       [self = shared_from_this(), this, callback = std::move(callback), highWater]() mutable {
-                           mHighWaterCallback = std::move(callback);
-                           mHighWater = highWater;
-                       });
+        runInLoop([self = shared_from_this(), this, callback = std::move(callback), highWater]() mutable {
+            mHighWaterCallback = std::move(callback);
+            mHighWater = highWater;
+        });
     }
 
     void close() noexcept
     {
-        asio::dispatch(mSocket.get_executor(),
-                       [self = shared_from_this(), this]() {
-                           causeClosed();
-                       });
+        runInLoop([self = shared_from_this(), this]() {
+            causeClosed(CloseReason::Local);
+        });
     }
 
     void shutdown(asio::ip::tcp::socket::shutdown_type type) noexcept
     {
-        asio::dispatch(mSocket.get_executor(), [self = shared_from_this(), this, type]() {
+        runInLoop([self = shared_from_this(), this, type]() {
             if (mSocket.is_open())
             {
                 try
@@ -131,59 +228,378 @@ public:
 
     void shrinkReceiveBuffer()
     {
-        asio::dispatch(mSocket.get_executor(),
-                       [self = shared_from_this(), this]() {
-                           mNeedShrinkReceiveBuffer = true;
-                       });
+        runInLoop([self = shared_from_this(), this]() {
+            mNeedShrinkReceiveBuffer = true;
+        });
     }
 
-    void send(SendableMsg::Ptr msg, SendCompletedCallback callback = nullptr) noexcept
+    // return false if session is closed or the message is rejected by memory budget.
+    bool send(SendableMsg::Ptr msg, SendCompletedCallback callback = nullptr) noexcept
     {
+        assertInLoopIfSingleThread();
         if (!mSocket.is_open())
         {
-            return;
+            return false;
+        }
+        if (mMemoryBudget != nullptr && mMemoryBudget->shouldRejectSend())
+        {
+            return false;
         }
         {
-            std::lock_guard<std::mutex> lck(mSendGuard);
-            mSendingSize += msg->size();
-            mPendingSendMsgList.emplace_back(std::move(msg), std::move(callback));
+            asio::detail::conditionally_enabled_mutex::scoped_lock lck(mSendGuard);
+            const auto size = msg->size();
+            mSendingSize += size;
+            if (mMemoryBudget != nullptr)
+            {
+                // file ranges are not held in memory
+                const auto bufferedSize = BufferedSize(msg);
+                mQueuedSendBytes.fetch_add(bufferedSize, std::memory_order_relaxed);
+                mMemoryBudget->addSendBytes(bufferedSize);
+                mPendingSendMsgList.emplace_back(std::move(msg), std::move(callback), this);
+            }
+            else
+            {
+                mPendingSendMsgList.emplace_back(std::move(msg), std::move(callback), nullptr);
+            }
 
             if (mSendingSize > mHighWater && mHighWaterCallback != nullptr)
             {
                 // prevent send data in high water callback, so use post defer execute.
-                asio::post(mSocket.get_executor(),
-                           [self = shared_from_this(), this]() {
-                               mHighWaterCallback();
-                           });
+                postInLoop([self = shared_from_this(), this]() {
+                    mHighWaterCallback();
+                });
             }
             if (mSending)
             {
-                return;
+                return true;
             }
         }
         tryFlush();
+        return true;
+    }
+
+    bool send(std::string msg, SendCompletedCallback callback = nullptr) noexcept
+    {
+        return send(MakeStringMsg(std::move(msg)), std::move(callback));
     }
 
-    void send(std::string msg, SendCompletedCallback callback = nullptr) noexcept
+    // stop posting receives, the receive in flight still completes.
+    void pauseRecv()
     {
-        send(MakeStringMsg(std::move(msg)), std::move(callback));
+        runInLoop([self = shared_from_this(), this]() {
+            mRecvPaused = true;
+        });
+    }
+
+    // data left in receive buffer when paused is passed to data handler again,
+    // always posted so it's not reentered from data handler.
+    void resumeRecv()
+    {
+        postInLoop([self = shared_from_this(), this]() {
+            if (!mRecvPaused)
+            {
+                return;
+            }
+            mRecvPaused = false;
+            if (!mSocket.is_open())
+            {
+                return;
+            }
+            if (mReceiveBuffer != nullptr && mReceiveBuffer->size() > 0)
+            {
+                tryProcessRecvBuffer();
+            }
+            startAsyncRecv();
+        });
+    }
+
+    // account receive buffer and send queue of session in budget,
+    // must be called in session's thread before startRecv.
+    void setMemoryBudget(MemoryBudget::Ptr budget)
+    {
+        assert(mMemoryBudget == nullptr);
+        mMemoryBudget = std::move(budget);
+        mMemoryBudget->track(this);
+        updateRecvBudget();
+    }
+
+    const MemoryBudget::Ptr& memoryBudget() const
+    {
+        return mMemoryBudget;
+    }
+
+    // timeouts are checked by the timer wheel of session's io_context, the session will be
+    // closed with the timeout reason, and activities only update timestamps of coarse clock.
+    void setTimeout(TcpSessionTimeout timeout)
+    {
+        runInLoop([self = shared_from_this(), this, timeout]() {
+            if (!mSocket.is_open())
+            {
+                return;
+            }
+            if (mTimerWheel == nullptr && timeout.enabled())
+            {
+                mTimerWheel = &TimerWheel::Get(mSocket.get_executor().context());
+                mTimerWheel->retainCoarseClock();
+                mTimeoutTimer.setCallback([weak = weak_from_this()]() {
+                    if (auto self = weak.lock())
+                    {
+                        self->runInLoop([self]() {
+                            self->checkTimeout();
+                        });
+                    }
+                });
+            }
+            mTimeout = timeout;
+            if (mTimerWheel != nullptr)
+            {
+                mLastRecvTime = mLastSendTime = mTimerWheel->coarseNow();
+                armTimeoutCheck();
+            }
+        });
+    }
+
+    // 0 if the session is not registered, see SessionRegistry.
+    uint64_t id() const noexcept
+    {
+        return mId;
+    }
+
+    void setId(uint64_t id) noexcept
+    {
+        mId = id;
+    }
+
+    // run handler after the current ClosedHandler, or directly if session is closed already.
+    // must be called in session's thread.
+    void appendClosedHandler(ClosedHandler handler)
+    {
+        if (!mSocket.is_open())
+        {
+            handler(shared_from_this());
+            return;
+        }
+        if (mClosedHandler == nullptr)
+        {
+            mClosedHandler = std::move(handler);
+            return;
+        }
+        mClosedHandler = [first = std::move(mClosedHandler), second = std::move(handler)](const Ptr& session) {
+            first(session);
+            second(session);
+        };
+    }
+
+    // construct user data in the slot of session, its memory is recycled by the pool of io_context.
+    // the user data is destroyed after ClosedHandler, must be called in session's thread.
+    template<typename T, typename... Args>
+    T& emplaceUserData(Args&&... args)
+    {
+        resetUserData();
+        const auto type = UserDataTypeOf<T>();
+        const auto data = mSessionPool.allocate(type->size, type->align);
+        try
+        {
+            new (data) T(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            mSessionPool.deallocate(data, type->size, type->align);
+            throw;
+        }
+        mUserData = data;
+        mUserDataType = type;
+        return *static_cast<T*>(data);
+    }
+
+    // nullptr if the slot is empty, T must be the type of emplaceUserData.
+    template<typename T>
+    T* userData() const noexcept
+    {
+        assert(mUserData == nullptr || mUserDataType == UserDataTypeOf<T>());
+        return static_cast<T*>(mUserData);
+    }
+
+    void resetUserData() noexcept
+    {
+        if (mUserData == nullptr)
+        {
+            return;
+        }
+        const auto data = mUserData;
+        const auto type = mUserDataType;
+        mUserData = nullptr;
+        mUserDataType = nullptr;
+        type->destroy(data);
+        mSessionPool.deallocate(data, type->size, type->align);
+    }
+
+    // valid in ClosedHandler.
+    CloseReason closeReason() const
+    {
+        return mCloseReason;
+    }
+
+    // limit the number of offloaded tasks in flight, 0 means unlimited.
+    void setMaxOffloadNum(size_t maxOffloadNum)
+    {
+        runInLoop([self = shared_from_this(), this, maxOffloadNum]() {
+            offloadState().maxNum = maxOffloadNum;
+        });
+    }
+
+    // run work in compute pool, then call done in session's io thread: done(error) if work
+    // returns void, else done(error, result), result is std::nullopt if work threw error.
+    // done callbacks are invoked in the order of offload calls.
+    // must be called in session's io thread(such as in DataHandler), return false
+    // if in-flight task num reach the limit or pool is stopped, when the in-flight task
+    // finished, session will try process receive buffer again.
+    template<typename Work, typename Done>
+    bool offload(base::WorkStealingPool& pool, Work work, Done done)
+    {
+        // completions are posted from pool threads
+        assert(!mSingleThread && "offload is not supported in single thread mode");
+        auto& state = offloadState();
+        if (state.maxNum != 0 && state.completions.size() >= state.maxNum)
+        {
+            state.blocked = true;
+            return false;
+        }
+
+        const auto seq = state.beginSeq + state.completions.size();
+        state.completions.emplace_back(nullptr);
+
+        const auto submitted = pool.submit([self = shared_from_this(), this, seq,
+                                            work = std::move(work), done = std::move(done)]() mutable {
+            std::function<void(void)> completion;
+            using Result = std::invoke_result_t<Work>;
+            try
+            {
+                if constexpr (std::is_void_v<Result>)
+                {
+                    work();
+                    completion = [done = std::move(done)]() mutable {
+                        done(std::exception_ptr());
+                    };
+                }
+                else
+                {
+                    std::optional<Result> result(work());
+                    completion = [done = std::move(done), result = std::move(result)]() mutable {
+                        done(std::exception_ptr(), std::move(result));
+                    };
+                }
+            }
+            catch (...)
+            {
+                // the failure is passed to done in the order of other completions
+                completion = [done = std::move(done), error = std::current_exception()]() mutable {
+                    if constexpr (std::is_void_v<Result>)
+                    {
+                        done(error);
+                    }
+                    else
+                    {
+                        done(error, std::optional<Result>());
+                    }
+                };
+            }
+
+            postInLoop([self = std::move(self), this, seq, completion = std::move(completion)]() mutable {
+                onOffloadCompleted(seq, std::move(completion));
+            });
+        });
+        if (!submitted)
+        {
+            state.completions.pop_back();
+        }
+
+        return submitted;
     }
 
 private:
+    struct OffloadState;
+    friend class MemoryBudget;
+
     TcpSession(asio::ip::tcp::socket socket,
                size_t maxRecvBufferSize,
                DataHandler dataHandler,
                ClosedHandler closedHandler,
-               EofHandler eofHandler)
+               EofHandler eofHandler,
+               bool useStrand)
         : mSocket(std::move(socket)),
+          mSingleThread(SingleThreadMode::Enabled(mSocket.get_executor().context())),
+          mSubmissionQueue(SubmissionQueue::Get(mSocket.get_executor().context())),
+          mSessionPool(SessionPool::Get(mSocket.get_executor().context())),
+          mSendGuard(!mSingleThread),
+          mReceiveBuffer(mSessionPool.acquireBuffer(std::max<size_t>(MinReceivePrepareSize, maxRecvBufferSize))),
           mDataHandler(std::move(dataHandler)),
-          mReceiveBuffer(
-                  std::make_unique<asio::streambuf>(std::max<size_t>(MinReceivePrepareSize, maxRecvBufferSize))),
           mClosedHandler(std::move(closedHandler)),
           mEofHandler(std::move(eofHandler))
     {
         mSocket.non_blocking(true);
         mSocket.set_option(asio::ip::tcp::no_delay(true));
+        BusyPollService::ApplyToSocket(mSocket);
+#ifdef BSIO_HAS_IO_URING
+        mUring = uring::UringService::Get(mSocket.get_executor().context());
+#endif
+        // single thread mode needs no serialization.
+        if (useStrand && !mSingleThread)
+        {
+            mStrand.emplace(mSocket.get_executor());
+        }
+    }
+
+    // run in session's thread, it's invoked directly in single thread mode.
+    template<typename F>
+    void runInLoop(F&& functor)
+    {
+        if (mSingleThread)
+        {
+            assertInLoopIfSingleThread();
+            functor();
+            return;
+        }
+        if (mStrand)
+        {
+            asio::dispatch(*mStrand, std::forward<F>(functor));
+            return;
+        }
+        asio::dispatch(mSocket.get_executor(), std::forward<F>(functor));
+    }
+
+    template<typename F>
+    void postInLoop(F&& functor)
+    {
+        if (mStrand)
+        {
+            asio::post(*mStrand, std::forward<F>(functor));
+            return;
+        }
+        asio::post(mSocket.get_executor(), std::forward<F>(functor));
+    }
+
+#ifdef BSIO_HAS_IO_URING
+    // uring invokes completions in io thread directly, so hop into the strand.
+    template<typename Handler>
+    auto strandHandler(Handler handler)
+    {
+        // keep the allocator of handler, so uring operation and strand hop reuse the handler memory.
+        const auto allocator = asio::get_associated_allocator(handler);
+        return MakeAllocatorHandler(allocator,
+                                    [strand = *mStrand, allocator, handler = std::move(handler)](std::error_code ec, size_t bytesTransferred) mutable {
+                                        asio::dispatch(strand,
+                                                       MakeAllocatorHandler(allocator,
+                                                                            [handler = std::move(handler), ec, bytesTransferred]() mutable {
+                                                                                handler(ec, bytesTransferred);
+                                                                            }));
+                                    });
+    }
+#endif
+
+    void assertInLoopIfSingleThread() const
+    {
+        assert(!mSingleThread || mSubmissionQueue.runningInThisThread());
     }
 
     void growReceiveBuffer()
@@ -235,8 +651,14 @@ private:
 
     void startAsyncRecv()
     {
-        if (mRecvPosted)
+        if (mRecvPosted || mRecvPaused || mBudgetPaused.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        if (mMemoryBudget != nullptr && mMemoryBudget->shouldPauseRead())
         {
+            mBudgetPaused.store(true, std::memory_order_relaxed);
+            mMemoryBudget->addPausedSession();
             return;
         }
 
@@ -248,12 +670,32 @@ private:
             {
                 throw std::runtime_error("buffer size is zero");
             }
-            mSocket.async_receive(
-                    buffer,
-                    [self = shared_from_this(), this](std::error_code ec, size_t bytesTransferred) {
-                        onRecvCompleted(ec, bytesTransferred);
-                    });
+            updateRecvBudget();
+            auto handler = MakeAllocHandler(mRecvHandlerMemory,
+                                            [self = shared_from_this(), this](std::error_code ec, size_t bytesTransferred) {
+                                                onRecvCompleted(ec, bytesTransferred);
+                                            });
             mRecvPosted = true;
+#ifdef BSIO_HAS_IO_URING
+            if (mUring != nullptr && mStrand)
+            {
+                mUring->asyncReceive(mSocket.native_handle(), buffer, strandHandler(std::move(handler)));
+                return;
+            }
+            if (mUring != nullptr)
+            {
+                mUring->asyncReceive(mSocket.native_handle(), buffer, std::move(handler));
+                return;
+            }
+#endif
+            if (mStrand)
+            {
+                mSocket.async_receive(buffer, asio::bind_executor(*mStrand, std::move(handler)));
+            }
+            else
+            {
+                mSocket.async_receive(buffer, std::move(handler));
+            }
         }
         catch (const std::length_error& ec)
         {
@@ -277,11 +719,15 @@ private:
             }
             else
             {
-                causeClosed();
+                causeClosed(ec == asio::error::eof ? CloseReason::PeerClosed : CloseReason::Error);
             }
             return;
         }
 
+        if (mTimerWheel != nullptr)
+        {
+            mLastRecvTime = mTimerWheel->coarseNow();
+        }
         mReceiveBuffer->commit(bytesTransferred);
         mReceivePos += bytesTransferred;
 
@@ -299,7 +745,7 @@ private:
     void tryFlush()
     {
         {
-            std::lock_guard<std::mutex> lck(mSendGuard);
+            asio::detail::conditionally_enabled_mutex::scoped_lock lck(mSendGuard);
             if (mSending || mPendingSendMsgList.empty())
             {
                 return;
@@ -307,36 +753,258 @@ private:
             std::swap(mSendingMsgList, mPendingSendMsgList);
             mSending = true;
         }
-        asio::dispatch(mSocket.get_executor(),
-                       [self = shared_from_this(), this]() {
-                           flush();
-                       });
+        if (mSingleThread)
+        {
+            flush();
+            return;
+        }
+        if (mStrand)
+        {
+            asio::dispatch(*mStrand, [self = shared_from_this(), this]() {
+                flush();
+            });
+            return;
+        }
+        // send from foreign threads is batched, one wakeup for many sessions.
+        mSubmissionQueue.dispatch([self = shared_from_this(), this]() {
+            flush();
+        });
     }
 
     void flush()
     {
         {
-            mBuffers.resize(mSendingMsgList.size());
-            for (std::size_t i = 0; i < mSendingMsgList.size(); ++i)
+            mBuffers.clear();
+            mFileSegments.clear();
+            for (const auto& msg : mSendingMsgList)
+            {
+                appendBuffers(msg.msg);
+            }
+        }
+        if (mTimerWheel != nullptr)
+        {
+            mWritePosted = true;
+            mLastSendTime = mTimerWheel->coarseNow();
+            if (mTimeout.write.count() > 0 &&
+                (!mTimeoutTimer.scheduled() || mLastSendTime + mTimeout.write < mTimeoutDeadline))
             {
-                auto& msg = mSendingMsgList[i];
-                mBuffers[i] = asio::const_buffer(static_cast<const char*>(msg.msg->data()), msg.msg->size());
+                armTimeoutCheck();
             }
         }
-        asio::async_write(mSocket, mBuffers,
-                          [self = shared_from_this(), this](std::error_code ec, size_t bytesTransferred) {
-                              onSendCompleted(ec, bytesTransferred);
-                          });
+
+        if (!mFileSegments.empty())
+        {
+            mFlushBufferPos = 0;
+            mFlushFileIndex = 0;
+            mFlushedBytes = 0;
+            flushNext();
+            return;
+        }
+
+        auto handler = MakeAllocHandler(mSendHandlerMemory,
+                                        [self = shared_from_this(), this](std::error_code ec, size_t bytesTransferred) {
+                                            onSendCompleted(ec, bytesTransferred);
+                                        });
+#ifdef BSIO_HAS_IO_URING
+        if (mUring != nullptr && mStrand)
+        {
+            mUring->asyncWrite(mSocket.native_handle(), mBuffers, strandHandler(std::move(handler)));
+            return;
+        }
+        if (mUring != nullptr)
+        {
+            mUring->asyncWrite(mSocket.native_handle(), mBuffers, std::move(handler));
+            return;
+        }
+#endif
+        const ConstBufferView buffers{mBuffers.data(), mBuffers.data() + mBuffers.size()};
+        if (mStrand)
+        {
+            asio::async_write(mSocket, buffers, SendProgress{this}, asio::bind_executor(*mStrand, std::move(handler)));
+            return;
+        }
+        asio::async_write(mSocket, buffers, SendProgress{this}, std::move(handler));
     }
 
+    // a write making progress is not stalled, refresh the send time for the write timeout.
+    void onSendProgress()
+    {
+        if (mTimerWheel != nullptr)
+        {
+            mLastSendTime = mTimerWheel->coarseNow();
+        }
+    }
+
+    void appendBuffers(const SendableMsg::Ptr& msg)
+    {
+        if (const auto segments = msg->segments())
+        {
+            for (const auto& segment : *segments)
+            {
+                appendBuffers(segment);
+            }
+            return;
+        }
+        if (const auto range = msg->fileRange())
+        {
+            if (range->size > 0)
+            {
+                mFileSegments.push_back(FileSegment{mBuffers.size(), *range});
+            }
+            return;
+        }
+        if (msg->size() > 0)
+        {
+            mBuffers.emplace_back(msg->data(), msg->size());
+        }
+    }
+
+    // messages with file ranges are sent in steps, the buffers before each range by one
+    // gather write, then the range. the steps complete as one write of the list.
+    void flushNext()
+    {
+        const auto bufferEnd = mFlushFileIndex < mFileSegments.size()
+                                       ? mFileSegments[mFlushFileIndex].bufferIndex
+                                       : mBuffers.size();
+        if (mFlushBufferPos < bufferEnd)
+        {
+            const ConstBufferView buffers{mBuffers.data() + mFlushBufferPos, mBuffers.data() + bufferEnd};
+            mFlushBufferPos = bufferEnd;
+            writeFileStep(buffers);
+            return;
+        }
+        if (mFlushFileIndex < mFileSegments.size())
+        {
+            sendFileRange();
+            return;
+        }
+        onSendCompleted(std::error_code(), mFlushedBytes);
+    }
+
+    template<typename ConstBufferSequence>
+    void writeFileStep(const ConstBufferSequence& buffers)
+    {
+        auto handler = MakeAllocHandler(mSendHandlerMemory,
+                                        [self = shared_from_this(), this](std::error_code ec, size_t bytesTransferred) {
+                                            if (ec)
+                                            {
+                                                onSendCompleted(ec, 0);
+                                                return;
+                                            }
+                                            mFlushedBytes += bytesTransferred;
+                                            onSendProgress();
+                                            flushNext();
+                                        });
+        // uring sessions also use the reactor here, the steps are never concurrent with a uring write.
+        if (mStrand)
+        {
+            asio::async_write(mSocket, buffers, SendProgress{this}, asio::bind_executor(*mStrand, std::move(handler)));
+            return;
+        }
+        asio::async_write(mSocket, buffers, SendProgress{this}, std::move(handler));
+    }
+
+#if defined(__linux__)
+    void sendFileRange()
+    {
+        auto& range = mFileSegments[mFlushFileIndex].range;
+        std::error_code ec;
+        if (!mSocket.native_non_blocking())
+        {
+            mSocket.native_non_blocking(true, ec);
+        }
+        while (!ec && range.size > 0)
+        {
+            auto offset = static_cast<off_t>(range.offset);
+            const auto n = ::sendfile(mSocket.native_handle(), range.fd, &offset, range.size);
+            if (n > 0)
+            {
+                range.offset += static_cast<uint64_t>(n);
+                range.size -= static_cast<size_t>(n);
+                mFlushedBytes += static_cast<size_t>(n);
+                onSendProgress();
+            }
+            else if (n == 0)
+            {
+                // the file is truncated while sending
+                ec = asio::error::eof;
+            }
+            else if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                auto handler = MakeAllocHandler(mSendHandlerMemory,
+                                                [self = shared_from_this(), this](std::error_code ec) {
+                                                    if (ec)
+                                                    {
+                                                        onSendCompleted(ec, 0);
+                                                        return;
+                                                    }
+                                                    sendFileRange();
+                                                });
+                if (mStrand)
+                {
+                    mSocket.async_wait(asio::socket_base::wait_write, asio::bind_executor(*mStrand, std::move(handler)));
+                }
+                else
+                {
+                    mSocket.async_wait(asio::socket_base::wait_write, std::move(handler));
+                }
+                return;
+            }
+            else if (errno != EINTR)
+            {
+                ec = std::error_code(errno, std::system_category());
+            }
+        }
+        if (ec)
+        {
+            onSendCompleted(ec, 0);
+            return;
+        }
+        mFlushFileIndex++;
+        flushNext();
+    }
+#else
+    // without sendfile the range is read into a chunk and written, one chunk at a time.
+    void sendFileRange()
+    {
+        constexpr size_t FileChunkSize = 64 * 1024;
+        auto& range = mFileSegments[mFlushFileIndex].range;
+        if (range.size == 0)
+        {
+            mFlushFileIndex++;
+            flushNext();
+            return;
+        }
+        if (mFileChunk == nullptr)
+        {
+            mFileChunk = std::make_unique<char[]>(FileChunkSize);
+        }
+        const auto n = internal::ReadFileAt(range.fd, mFileChunk.get(), std::min(range.size, FileChunkSize), range.offset);
+        if (n <= 0)
+        {
+            onSendCompleted(n == 0 ? std::error_code(asio::error::eof) : std::error_code(errno, std::system_category()), 0);
+            return;
+        }
+        range.offset += static_cast<uint64_t>(n);
+        range.size -= static_cast<size_t>(n);
+        writeFileStep(asio::buffer(mFileChunk.get(), static_cast<size_t>(n)));
+    }
+#endif
+
     void onSendCompleted(std::error_code ec, size_t bytesTransferred)
     {
         if (ec)
         {
-            causeClosed();
+            causeClosed(CloseReason::Error);
             return;
         }
 
+        if (mTimerWheel != nullptr)
+        {
+            mWritePosted = false;
+            mLastSendTime = mTimerWheel->coarseNow();
+        }
+
         for (const auto& msg : mSendingMsgList)
         {
             if (msg.callback)
@@ -347,7 +1015,7 @@ private:
         mSendingMsgList.clear();
 
         {
-            std::lock_guard<std::mutex> lck(mSendGuard);
+            asio::detail::conditionally_enabled_mutex::scoped_lock lck(mSendGuard);
             mSending = false;
             mSendingSize -= bytesTransferred;
         }
@@ -355,6 +1023,36 @@ private:
         tryFlush();
     }
 
+    OffloadState& offloadState()
+    {
+        if (mOffload == nullptr)
+        {
+            mOffload = std::make_unique<OffloadState>();
+        }
+        return *mOffload;
+    }
+
+    void onOffloadCompleted(uint64_t seq, std::function<void(void)> completion)
+    {
+        auto& state = *mOffload;
+        state.completions[seq - state.beginSeq] = std::move(completion);
+        while (!state.completions.empty() && state.completions.front() != nullptr)
+        {
+            auto current = std::move(state.completions.front());
+            state.completions.pop_front();
+            state.beginSeq++;
+            current();
+        }
+
+        if (state.blocked && mSocket.is_open() &&
+            (state.maxNum == 0 || state.completions.size() < state.maxNum))
+        {
+            state.blocked = false;
+            tryProcessRecvBuffer();
+            startAsyncRecv();
+        }
+    }
+
     void tryProcessRecvBuffer()
     {
         if (mDataHandler == nullptr)
@@ -400,6 +1098,56 @@ private:
         tmp->commit(tmp->sputn(static_cast<const char*>(validReadBuffer.data()), validReadBuffer.size()));
         mReceivePos = tmp->data().size();
         mReceiveBuffer = std::move(tmp);
+        updateRecvBudget();
+    }
+
+    // the capacity of receive buffer is accounted, it changes when the buffer grows or shrinks.
+    void updateRecvBudget()
+    {
+        if (mMemoryBudget == nullptr)
+        {
+            return;
+        }
+        const auto capacity = mReceiveBuffer != nullptr ? mReceiveBuffer->capacity() : 0;
+        if (capacity > mAccountedRecvBytes)
+        {
+            mMemoryBudget->addRecvBytes(capacity - mAccountedRecvBytes);
+        }
+        else if (capacity < mAccountedRecvBytes)
+        {
+            mMemoryBudget->subRecvBytes(mAccountedRecvBytes - capacity);
+        }
+        mAccountedRecvBytes = capacity;
+    }
+
+    void releaseSendBytes(size_t size)
+    {
+        mQueuedSendBytes.fetch_sub(size, std::memory_order_relaxed);
+        mMemoryBudget->subSendBytes(size);
+    }
+
+    // called by budget from any thread.
+    void resumeRecvByBudget()
+    {
+        postInLoop([self = shared_from_this(), this]() {
+            if (!mBudgetPaused.load(std::memory_order_relaxed))
+            {
+                return;
+            }
+            mBudgetPaused.store(false, std::memory_order_relaxed);
+            mMemoryBudget->removePausedSession();
+            if (mSocket.is_open())
+            {
+                startAsyncRecv();
+            }
+        });
+    }
+
+    void shedByBudget()
+    {
+        postInLoop([self = shared_from_this(), this]() {
+            causeClosed(CloseReason::MemoryPressure);
+        });
     }
 
     void causeEof()
@@ -411,7 +1159,63 @@ private:
         }
     }
 
-    void causeClosed()
+    TimerWheel::Clock::time_point nextTimeoutDeadline() const
+    {
+        auto deadline = TimerWheel::Clock::time_point::max();
+        if (mTimeout.idle.count() > 0)
+        {
+            deadline = std::min(deadline, std::max(mLastRecvTime, mLastSendTime) + mTimeout.idle);
+        }
+        if (mTimeout.read.count() > 0)
+        {
+            deadline = std::min(deadline, mLastRecvTime + mTimeout.read);
+        }
+        if (mTimeout.write.count() > 0 && mWritePosted)
+        {
+            deadline = std::min(deadline, mLastSendTime + mTimeout.write);
+        }
+        return deadline;
+    }
+
+    void armTimeoutCheck()
+    {
+        mTimeoutDeadline = nextTimeoutDeadline();
+        if (mTimeoutDeadline == TimerWheel::Clock::time_point::max())
+        {
+            mTimeoutTimer.cancel();
+            return;
+        }
+        mTimerWheel->schedule(mTimeoutTimer, mTimeoutDeadline - mTimerWheel->coarseNow());
+    }
+
+    void checkTimeout()
+    {
+        if (!mSocket.is_open())
+        {
+            return;
+        }
+
+        const auto now = mTimerWheel->coarseNow();
+        if (mTimeout.write.count() > 0 && mWritePosted && now - mLastSendTime >= mTimeout.write)
+        {
+            causeClosed(CloseReason::WriteTimeout);
+        }
+        else if (mTimeout.read.count() > 0 && now - mLastRecvTime >= mTimeout.read)
+        {
+            causeClosed(CloseReason::ReadTimeout);
+        }
+        else if (mTimeout.idle.count() > 0 && now - std::max(mLastRecvTime, mLastSendTime) >= mTimeout.idle)
+        {
+            causeClosed(CloseReason::IdleTimeout);
+        }
+        else
+        {
+            // activities happened since last check
+            armTimeoutCheck();
+        }
+    }
+
+    void causeClosed(CloseReason reason)
     {
         try
         {
@@ -421,13 +1225,37 @@ private:
                 return;
             }
 
+            mCloseReason = reason;
+            if (mTimerWheel != nullptr)
+            {
+                mTimeoutTimer.cancel();
+                mTimerWheel->releaseCoarseClock();
+                mTimerWheel = nullptr;
+            }
+
+#ifdef BSIO_HAS_IO_URING
+            if (mUring != nullptr)
+            {
+                mUring->cancel(mSocket.native_handle());
+            }
+#endif
             mSocket.close();
+            // messages not written are dropped, the list being written is kept for the operation in flight.
+            {
+                std::vector<PendingMsg> pendingMsgList;
+                {
+                    asio::detail::conditionally_enabled_mutex::scoped_lock lck(mSendGuard);
+                    std::swap(pendingMsgList, mPendingSendMsgList);
+                }
+            }
             if (mClosedHandler != nullptr)
             {
                 mClosedHandler(shared_from_this());
                 mClosedHandler = nullptr;
             }
             mDataHandler = nullptr;
+            mEofHandler = nullptr;
+            resetUserData();
         }
         catch (...)
         {
@@ -435,38 +1263,256 @@ private:
     }
 
 private:
-    asio::ip::tcp::socket mSocket;
+    // the write operation copies buffer sequence, so pass a view of mBuffers rather than the vector.
+    struct ConstBufferView {
+        const asio::const_buffer* first;
+        const asio::const_buffer* last;
 
-    // 同时只能发起一次send writev请求
-    bool mSending = false;
-    std::mutex mSendGuard;
+        const asio::const_buffer* begin() const
+        {
+            return first;
+        }
+
+        const asio::const_buffer* end() const
+        {
+            return last;
+        }
+    };
+
+    // completion condition of async_write, called in the write's executor after each partial write.
+    struct SendProgress {
+        TcpSession* session;
+
+        size_t operator()(const std::error_code& ec, size_t bytesTransferred) const
+        {
+            if (bytesTransferred > 0)
+            {
+                session->onSendProgress();
+            }
+            return asio::transfer_all()(ec, bytesTransferred);
+        }
+    };
+
+    // a file range to send after the first bufferIndex buffers of mBuffers.
+    struct FileSegment {
+        size_t bufferIndex;
+        FileRange range;
+    };
+
+    struct UserDataType {
+        size_t size;
+        size_t align;
+        void (*destroy)(void*);
+    };
+
+    // the address of descriptor identifies the type.
+    template<typename T>
+    static const UserDataType* UserDataTypeOf() noexcept
+    {
+        static const UserDataType type{sizeof(T), alignof(T), [](void* data) {
+                                           static_cast<T*>(data)->~T();
+                                       }};
+        return &type;
+    }
+
+    struct OffloadState {
+        size_t maxNum = 0;
+        bool blocked = false;
+        uint64_t beginSeq = 0;
+        std::deque<std::function<void(void)>> completions;
+    };
+
+    // owner is set if session has memory budget, the bytes of message are released when it's dropped.
     struct PendingMsg {
         PendingMsg() = default;
-        PendingMsg(SendableMsg::Ptr m, SendCompletedCallback c)
+        PendingMsg(SendableMsg::Ptr m, SendCompletedCallback c, TcpSession* o)
             : msg(std::move(m)),
-              callback(std::move(c))
+              callback(std::move(c)),
+              owner(o)
+        {}
+        PendingMsg(PendingMsg&& other) noexcept
+            : msg(std::move(other.msg)),
+              callback(std::move(other.callback)),
+              owner(other.owner)
         {}
+        PendingMsg& operator=(PendingMsg&& other) noexcept
+        {
+            release();
+            msg = std::move(other.msg);
+            callback = std::move(other.callback);
+            owner = other.owner;
+            return *this;
+        }
+        ~PendingMsg()
+        {
+            release();
+        }
+        void release() noexcept
+        {
+            if (owner != nullptr && msg != nullptr)
+            {
+                owner->releaseSendBytes(BufferedSize(msg));
+            }
+        }
         SendableMsg::Ptr msg;
         SendCompletedCallback callback;
+        TcpSession* owner = nullptr;
     };
 
-    std::vector<PendingMsg> mSendingMsgList;
-    std::vector<PendingMsg> mPendingSendMsgList;
-    std::vector<asio::const_buffer> mBuffers;
+    // fields are grouped by the thread writing them, hot groups start at their own cache line,
+    // so threads calling send() don't false share lines with the receive and write path.
+
+    // read-mostly, shared by io thread and threads calling send()
+    asio::ip::tcp::socket mSocket;
+    uint64_t mId = 0;
+    const bool mSingleThread;
+    SubmissionQueue& mSubmissionQueue;
+    SessionPool& mSessionPool;
+    MemoryBudget::Ptr mMemoryBudget;
+    // serializes completions when io_context is run by multi threads
+    std::optional<asio::strand<asio::executor>> mStrand;
+#ifdef BSIO_HAS_IO_URING
+    uring::UringService* mUring = nullptr;
+#endif
+
+    // producer side, written by threads calling send()
+    // locking is disabled in single thread mode
+    alignas(64) asio::detail::conditionally_enabled_mutex mSendGuard;
+    // 同时只能发起一次send writev请求
+    bool mSending = false;
     size_t mSendingSize = 0;
-    HighWaterCallback mHighWaterCallback;
     size_t mHighWater = 16 * 1024 * 1024;
+    // bytes of queued messages accounted in budget, read by the budget when shedding
+    std::atomic<size_t> mQueuedSendBytes{0};
+    std::vector<PendingMsg> mPendingSendMsgList;
+    HighWaterCallback mHighWaterCallback;
 
-    bool mRecvPosted = false;
-    DataHandler mDataHandler;
-    std::unique_ptr<asio::streambuf> mReceiveBuffer;
+    // receive path, only io thread
+    alignas(64) bool mRecvPosted = false;
+    bool mRecvPaused = false;
+    // written by io thread, read by budget when resuming
+    std::atomic<bool> mBudgetPaused{false};
+    bool mNeedShrinkReceiveBuffer = false;
+    size_t mAccountedRecvBytes = 0;
     size_t mReceivePos = 0;
+    std::unique_ptr<asio::streambuf> mReceiveBuffer;
+    DataHandler mDataHandler;
+    void* mUserData = nullptr;
+    double mCurrentTanhXDiff = 0;
+    TimerWheel::Clock::time_point mLastRecvTime;
+    // recurring receive and write operations reuse these blocks instead of heap.
+    HandlerMemory<256> mRecvHandlerMemory;
+
+    // write path, only io thread
+    alignas(64) bool mWritePosted = false;
+    std::vector<PendingMsg> mSendingMsgList;
+    std::vector<asio::const_buffer> mBuffers;
+    std::vector<FileSegment> mFileSegments;
+    size_t mFlushBufferPos = 0;
+    size_t mFlushFileIndex = 0;
+    size_t mFlushedBytes = 0;
+#if !defined(__linux__)
+    std::unique_ptr<char[]> mFileChunk;
+#endif
+    TimerWheel::Clock::time_point mLastSendTime;
+    HandlerMemory<512> mSendHandlerMemory;
+
+    // cold
+    const UserDataType* mUserDataType = nullptr;
     ClosedHandler mClosedHandler;
     EofHandler mEofHandler;
-    double mCurrentTanhXDiff = 0;
-    bool mNeedShrinkReceiveBuffer = false;
+    CloseReason mCloseReason = CloseReason::None;
+    TcpSessionTimeout mTimeout;
+    TimerWheel* mTimerWheel = nullptr;
+    WheelTimer mTimeoutTimer;
+    TimerWheel::Clock::time_point mTimeoutDeadline;
+    // position in the session list of budget, guarded by the budget
+    size_t mBudgetIndex = 0;
+
+    // created by the first offload, most sessions never offload.
+    std::unique_ptr<OffloadState> mOffload;
 };
 
 using TcpSessionEstablishHandler = std::function<void(TcpSession::Ptr)>;
 
+inline void MemoryBudget::track(TcpSession* session)
+{
+    std::lock_guard<std::mutex> lck(mSessionsGuard);
+    session->mBudgetIndex = mSessions.size();
+    mSessions.push_back(session);
+    mSessionNum.store(mSessions.size(), std::memory_order_relaxed);
+}
+
+inline void MemoryBudget::untrack(TcpSession* session)
+{
+    std::lock_guard<std::mutex> lck(mSessionsGuard);
+    const auto last = mSessions.back();
+    mSessions[session->mBudgetIndex] = last;
+    last->mBudgetIndex = session->mBudgetIndex;
+    mSessions.pop_back();
+    mSessionNum.store(mSessions.size(), std::memory_order_relaxed);
+}
+
+// a session being destroyed blocks in untrack, so it's still valid under the lock and lock() of its
+// weak reference returns nullptr. references are released outside the lock by the caller.
+template<typename Predicate>
+std::vector<TcpSession::Ptr> MemoryBudget::liveSessions(Predicate&& predicate)
+{
+    std::vector<TcpSession::Ptr> sessions;
+    std::lock_guard<std::mutex> lck(mSessionsGuard);
+    for (const auto session : mSessions)
+    {
+        if (!predicate(*session))
+        {
+            continue;
+        }
+        if (auto ptr = session->weak_from_this().lock())
+        {
+            sessions.push_back(std::move(ptr));
+        }
+    }
+    return sessions;
+}
+
+inline void MemoryBudget::shedLargestSession()
+{
+    std::vector<std::pair<size_t, TcpSession::Ptr>> candidates;
+    for (auto& session : liveSessions([](const TcpSession& session) {
+             return session.mQueuedSendBytes.load(std::memory_order_relaxed) > 0;
+         }))
+    {
+        const auto bytes = session->mQueuedSendBytes.load(std::memory_order_relaxed);
+        candidates.emplace_back(bytes, std::move(session));
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+        return a.first > b.first;
+    });
+
+    // shed the largest queues until usage would drop below high water
+    auto usedBytes = this->usedBytes();
+    for (const auto& [bytes, session] : candidates)
+    {
+        if (usedBytes < mHighWater)
+        {
+            break;
+        }
+        session->shedByBudget();
+        usedBytes -= std::min(usedBytes, bytes);
+    }
+}
+
+inline void MemoryBudget::resumePausedSessions()
+{
+    if (mPausedNum.load() == 0)
+    {
+        return;
+    }
+    for (const auto& session : liveSessions([](const TcpSession& session) {
+             return session.mBudgetPaused.load(std::memory_order_relaxed);
+         }))
+    {
+        session->resumeRecvByBudget();
+    }
+}
+
 }// namespace bsio::net
@@ -0,0 +1,542 @@
+#pragma once
+
+#include <array>
+#include <asio.hpp>
+#include <asio/detail/conditionally_enabled_mutex.hpp>
+#include <atomic>
+#include <bsio/net/SingleThreadMode.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace bsio::net {
+
+class TimerWheel;
+
+// intrusive timer node, owner must keep it alive while it is scheduled,
+// it's cancelled automatically when destroyed, also while its callback is running.
+class WheelTimer : private asio::noncopyable
+{
+public:
+    using Ptr = std::shared_ptr<WheelTimer>;
+    using Callback = std::function<void(void)>;
+
+    WheelTimer() = default;
+
+    explicit WheelTimer(Callback callback)
+        : mCallback(std::move(callback))
+    {
+    }
+
+    inline ~WheelTimer();
+
+    inline void setCallback(Callback callback);
+
+    bool scheduled() const
+    {
+        return mPrevNext != nullptr;
+    }
+
+    inline void cancel();
+
+private:
+    Callback mCallback;
+    TimerWheel* mWheel = nullptr;
+    WheelTimer* mNext = nullptr;
+    WheelTimer** mPrevNext = nullptr;
+    uint64_t mExpireTick = 0;
+    uint64_t mPeriodTicks = 0;
+    // the callback is running, guarded by the lock of wheel
+    bool mRunning = false;
+    // hold the timer created by runAfter/runEvery until it's finished.
+    Ptr mSelfHold;
+
+    friend class TimerWheel;
+};
+
+// per io_context hierarchical timer wheel(4 levels, 1ms tick),
+// insert and cancel are O(1), and only one asio::steady_timer drives all timers.
+class TimerWheel : public asio::execution_context::service
+{
+public:
+    using key_type = TimerWheel;
+    inline static asio::execution_context::id id;
+
+    using Clock = std::chrono::steady_clock;
+    static constexpr auto Tick = std::chrono::milliseconds(1);
+    static constexpr auto CoarseResolution = std::chrono::milliseconds(10);
+
+    explicit TimerWheel(asio::execution_context& context)
+        : asio::execution_context::service(context),
+          mGuard(!SingleThreadMode::Enabled(context)),
+          mTimer(static_cast<asio::io_context&>(context)),
+          mBaseTime(Clock::now()),
+          mCoarseNow(mBaseTime.time_since_epoch().count())
+    {
+    }
+
+    static TimerWheel& Get(asio::execution_context& context)
+    {
+        return asio::use_service<TimerWheel>(context);
+    }
+
+    // schedule timer fire after delay(round up to tick), and then every period if period is not zero.
+    // reschedule a scheduled timer will cancel it first.
+    void schedule(WheelTimer& timer, std::chrono::nanoseconds delay, std::chrono::nanoseconds period = std::chrono::nanoseconds::zero())
+    {
+        Lock lck(mGuard);
+        scheduleLocked(timer, delay, period);
+    }
+
+    void cancel(WheelTimer& timer)
+    {
+        WheelTimer::Ptr hold;
+        {
+            Lock lck(mGuard);
+            unlink(timer);
+            hold = std::move(timer.mSelfHold);
+        }
+    }
+
+    // the callback is replaced after the running one returns, and the running one is destroyed then.
+    void setCallback(WheelTimer& timer, WheelTimer::Callback callback)
+    {
+        Lock lck(mGuard);
+        forgetFiring(timer);
+        // the old callback is destroyed outside the lock, with the parameter
+        std::swap(timer.mCallback, callback);
+    }
+
+    WheelTimer::Ptr runAfter(std::chrono::nanoseconds timeout, WheelTimer::Callback callback)
+    {
+        auto timer = std::make_shared<WheelTimer>(std::move(callback));
+        timer->mSelfHold = timer;
+        schedule(*timer, timeout);
+        return timer;
+    }
+
+    // the callback is called every period until the timer is cancelled, no allocation after the first.
+    WheelTimer::Ptr runEvery(std::chrono::nanoseconds period, WheelTimer::Callback callback)
+    {
+        auto timer = std::make_shared<WheelTimer>(std::move(callback));
+        timer->mSelfHold = timer;
+        schedule(*timer, period, period);
+        return timer;
+    }
+
+    // coarse clock for hot paths, it's refreshed when the wheel is processed,
+    // and every CoarseResolution while it's retained.
+    Clock::time_point coarseNow() const
+    {
+        return Clock::time_point(Clock::duration(mCoarseNow.load(std::memory_order_relaxed)));
+    }
+
+    void retainCoarseClock()
+    {
+        Lock lck(mGuard);
+        if (mCoarseClockUsers++ == 0)
+        {
+            scheduleLocked(mCoarseClockTimer, CoarseResolution, CoarseResolution);
+        }
+    }
+
+    void releaseCoarseClock()
+    {
+        Lock lck(mGuard);
+        if (mCoarseClockUsers > 0 && --mCoarseClockUsers == 0)
+        {
+            unlink(mCoarseClockTimer);
+        }
+    }
+
+    size_t size() const
+    {
+        Lock lck(mGuard);
+        return mTimerNum;
+    }
+
+private:
+    using Lock = asio::detail::conditionally_enabled_mutex::scoped_lock;
+
+    static constexpr int Level0Bits = 8;
+    static constexpr int LevelNBits = 6;
+    static constexpr int LevelNum = 4;
+    static constexpr uint64_t Level0Size = 1u << Level0Bits;
+    static constexpr uint64_t LevelNSize = 1u << LevelNBits;
+    static constexpr uint64_t MaxTicks = uint64_t(1) << (Level0Bits + (LevelNum - 1) * LevelNBits);
+
+    // a callback moved out of its timer while it's running, it's moved back after the call if
+    // the timer is still alive and its callback is not replaced, then timer is set to nullptr.
+    struct Firing {
+        WheelTimer* timer;
+        Firing* next;
+    };
+
+    // must hold mGuard
+    void scheduleLocked(WheelTimer& timer, std::chrono::nanoseconds delay, std::chrono::nanoseconds period)
+    {
+        unlink(timer);
+
+        const auto now = Clock::now();
+        const auto nowTick = toTick(now);
+        if (mTimerNum == 0 && mCurrentTick < nowTick)
+        {
+            mCurrentTick = nowTick;
+        }
+        mCoarseNow.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+
+        timer.mWheel = this;
+        timer.mExpireTick = durationToTicks(now - mBaseTime + delay);
+        timer.mPeriodTicks = period > std::chrono::nanoseconds::zero() ? durationToTicks(period) : 0;
+        insert(timer);
+        tryArm(timer.mExpireTick);
+    }
+
+    uint64_t toTick(Clock::time_point t) const
+    {
+        return static_cast<uint64_t>((t - mBaseTime) / Tick);
+    }
+
+    static uint64_t durationToTicks(std::chrono::nanoseconds d)
+    {
+        const auto ticks = (d + Tick - std::chrono::nanoseconds(1)) / Tick;
+        return ticks > 0 ? static_cast<uint64_t>(ticks) : 1;
+    }
+
+    static uint64_t levelIndex(uint64_t tick, int level)
+    {
+        if (level == 0)
+        {
+            return tick & (Level0Size - 1);
+        }
+        return (tick >> (Level0Bits + (level - 1) * LevelNBits)) & (LevelNSize - 1);
+    }
+
+    WheelTimer*& slot(int level, uint64_t index)
+    {
+        if (level == 0)
+        {
+            return mLevel0[index];
+        }
+        return mLevelN[level - 1][index];
+    }
+
+    void pushFront(WheelTimer*& head, WheelTimer& timer)
+    {
+        timer.mNext = head;
+        if (head != nullptr)
+        {
+            head->mPrevNext = &timer.mNext;
+        }
+        head = &timer;
+        timer.mPrevNext = &head;
+    }
+
+    void insert(WheelTimer& timer)
+    {
+        const auto expire = std::max(timer.mExpireTick, mCurrentTick + 1);
+        const auto delta = expire - mCurrentTick;
+
+        if (delta < Level0Size)
+        {
+            pushFront(slot(0, levelIndex(expire, 0)), timer);
+        }
+        else
+        {
+            int level = 1;
+            uint64_t range = Level0Size * LevelNSize;
+            while (level < LevelNum - 1 && delta >= range)
+            {
+                level++;
+                range *= LevelNSize;
+            }
+            // too far, park it in the last level, it will be reinserted when cascading.
+            const auto placeTick = delta < MaxTicks ? expire : mCurrentTick + MaxTicks - 1;
+            pushFront(slot(level, levelIndex(placeTick, level)), timer);
+        }
+        mTimerNum++;
+    }
+
+    void unlink(WheelTimer& timer)
+    {
+        if (timer.mPrevNext == nullptr)
+        {
+            return;
+        }
+        *timer.mPrevNext = timer.mNext;
+        if (timer.mNext != nullptr)
+        {
+            timer.mNext->mPrevNext = timer.mPrevNext;
+        }
+        timer.mNext = nullptr;
+        timer.mPrevNext = nullptr;
+        mTimerNum--;
+    }
+
+    // move timers of slot to lower levels, return the slot index.
+    uint64_t cascade(int level)
+    {
+        const auto index = levelIndex(mCurrentTick, level);
+        auto timer = slot(level, index);
+        while (timer != nullptr)
+        {
+            auto next = timer->mNext;
+            unlink(*timer);
+            insert(*timer);
+            timer = next;
+        }
+        return index;
+    }
+
+    // the earliest tick that the wheel must be processed at.
+    uint64_t nextProcessTick() const
+    {
+        const auto current = levelIndex(mCurrentTick, 0);
+        for (uint64_t i = current + 1; i < Level0Size; i++)
+        {
+            if (mLevel0[i] != nullptr)
+            {
+                return mCurrentTick + (i - current);
+            }
+        }
+        // cascade point
+        return (mCurrentTick | (Level0Size - 1)) + 1;
+    }
+
+    void tickOnce()
+    {
+        mCurrentTick++;
+        const auto index = levelIndex(mCurrentTick, 0);
+        if (index == 0)
+        {
+            for (int level = 1; level < LevelNum && cascade(level) == 0; level++)
+            {
+            }
+        }
+
+        auto& head = slot(0, index);
+        while (head != nullptr)
+        {
+            auto timer = head;
+            unlink(*timer);
+            pushFront(mExpired, *timer);
+            mTimerNum++;
+        }
+    }
+
+    void advance(uint64_t nowTick)
+    {
+        while (mCurrentTick < nowTick)
+        {
+            if (mTimerNum == 0)
+            {
+                mCurrentTick = nowTick;
+                break;
+            }
+            const auto next = nextProcessTick();
+            if (next > nowTick)
+            {
+                mCurrentTick = nowTick;
+                break;
+            }
+            mCurrentTick = next - 1;
+            tickOnce();
+        }
+    }
+
+    // must hold mGuard
+    void tryArm(uint64_t tick)
+    {
+        if (mArmed && mArmedTick <= tick)
+        {
+            return;
+        }
+        mArmed = true;
+        mArmedTick = tick;
+        mTimer.expires_at(mBaseTime + Tick * tick);
+        mTimer.async_wait([this](const asio::error_code& ec) {
+            if (ec != asio::error::operation_aborted)
+            {
+                onTimer();
+            }
+        });
+    }
+
+    // must hold mGuard
+    void rearm()
+    {
+        if (mTimerNum > 0)
+        {
+            tryArm(nextProcessTick());
+        }
+    }
+
+    void onTimer()
+    {
+        Lock lck(mGuard);
+        mArmed = false;
+        const auto now = Clock::now();
+        mCoarseNow.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+        advance(toTick(now));
+
+        // fire one by one, so a callback can cancel or destroy other expired timers safely.
+        while (mExpired != nullptr)
+        {
+            auto timer = mExpired;
+            unlink(*timer);
+            if (timer->mRunning)
+            {
+                // the callback is running in other thread, fire it again after that.
+                timer->mExpireTick = mCurrentTick + 1;
+                insert(*timer);
+                continue;
+            }
+
+            auto hold = std::move(timer->mSelfHold);
+            if (timer->mPeriodTicks > 0)
+            {
+                timer->mExpireTick += timer->mPeriodTicks;
+                timer->mSelfHold = hold;
+                insert(*timer);
+            }
+
+            // the wheel owns the callback during the call, so the timer can be destroyed or
+            // reset by the callback itself or by other threads.
+            auto callback = std::move(timer->mCallback);
+            timer->mRunning = true;
+            Firing firing{timer, mFiring};
+            mFiring = &firing;
+            lck.unlock();
+            if (callback)
+            {
+                callback();
+            }
+            hold.reset();
+            lck.lock();
+
+            auto link = &mFiring;
+            while (*link != &firing)
+            {
+                link = &(*link)->next;
+            }
+            *link = firing.next;
+            if (firing.timer != nullptr)
+            {
+                firing.timer->mRunning = false;
+                firing.timer->mCallback = std::move(callback);
+            }
+            else if (callback)
+            {
+                lck.unlock();
+                callback = nullptr;
+                lck.lock();
+            }
+        }
+
+        rearm();
+    }
+
+    // must hold mGuard
+    void forgetFiring(WheelTimer& timer)
+    {
+        for (auto firing = mFiring; firing != nullptr; firing = firing->next)
+        {
+            if (firing->timer == &timer)
+            {
+                firing->timer = nullptr;
+                timer.mRunning = false;
+            }
+        }
+    }
+
+    void destroy(WheelTimer& timer)
+    {
+        Lock lck(mGuard);
+        unlink(timer);
+        forgetFiring(timer);
+    }
+
+    void shutdown() override
+    {
+        // break reference cycles of runAfter/runEvery timers, release them outside the lock.
+        std::vector<WheelTimer::Ptr> holds;
+        Lock lck(mGuard);
+        asio::error_code ec;
+        mTimer.cancel(ec);
+
+        const auto releaseSlot = [&, this](WheelTimer*& head) {
+            while (head != nullptr)
+            {
+                auto timer = head;
+                unlink(*timer);
+                timer->mWheel = nullptr;
+                if (timer->mSelfHold)
+                {
+                    holds.push_back(std::move(timer->mSelfHold));
+                }
+            }
+        };
+        for (auto& head : mLevel0)
+        {
+            releaseSlot(head);
+        }
+        for (auto& level : mLevelN)
+        {
+            for (auto& head : level)
+            {
+                releaseSlot(head);
+            }
+        }
+        releaseSlot(mExpired);
+    }
+
+private:
+    // locking is disabled in single thread mode
+    mutable asio::detail::conditionally_enabled_mutex mGuard;
+    asio::steady_timer mTimer;
+    const Clock::time_point mBaseTime;
+    std::atomic<Clock::rep> mCoarseNow;
+    WheelTimer mCoarseClockTimer;
+    size_t mCoarseClockUsers = 0;
+    uint64_t mCurrentTick = 0;
+    size_t mTimerNum = 0;
+    bool mArmed = false;
+    uint64_t mArmedTick = 0;
+
+    std::array<WheelTimer*, Level0Size> mLevel0 = {};
+    std::array<std::array<WheelTimer*, LevelNSize>, LevelNum - 1> mLevelN = {};
+    WheelTimer* mExpired = nullptr;
+    Firing* mFiring = nullptr;
+
+    friend class WheelTimer;
+};
+
+WheelTimer::~WheelTimer()
+{
+    if (mWheel != nullptr)
+    {
+        mWheel->destroy(*this);
+    }
+}
+
+void WheelTimer::setCallback(Callback callback)
+{
+    if (mWheel != nullptr)
+    {
+        mWheel->setCallback(*this, std::move(callback));
+        return;
+    }
+    mCallback = std::move(callback);
+}
+
+void WheelTimer::cancel()
+{
+    if (mWheel != nullptr)
+    {
+        mWheel->cancel(*this);
+    }
+}
+
+}// namespace bsio::net
@@ -1,8 +1,14 @@
 #pragma once
 
 #include <asio.hpp>
+#include <bsio/net/BusyPoll.hpp>
+#include <bsio/net/SingleThreadMode.hpp>
+#include <bsio/net/SubmissionQueue.hpp>
+#include <bsio/net/TimerWheel.hpp>
+#include <chrono>
 #include <functional>
 #include <memory>
+#include <optional>
 
 namespace bsio::net {
 
@@ -13,10 +19,15 @@ class WrapperIoContext : private asio::noncopyable
 public:
     using Ptr = std::shared_ptr<WrapperIoContext>;
 
+    // ASIO_CONCURRENCY_HINT_UNSAFE enables single thread mode of sessions and timers.
     explicit WrapperIoContext(int concurrencyHint)
         : mTrickyIoContext(std::make_shared<asio::io_context>(concurrencyHint)),
           mIoContext(*mTrickyIoContext)
     {
+        if (SingleThreadMode::IsUnsafeConcurrencyHint(concurrencyHint))
+        {
+            SingleThreadMode::Enable(mIoContext);
+        }
     }
 
     explicit WrapperIoContext(asio::io_context& ioContext)
@@ -29,9 +40,25 @@ public:
         stop();
     }
 
+    // must be called before run.
+    void setBusyPoll(BusyPollOption option)
+    {
+        if (option.minSpin > option.maxSpin)
+        {
+            throw std::runtime_error("min spin is larger than max spin");
+        }
+        asio::use_service<BusyPollService>(mIoContext).setSocketBusyPoll(option.socketBusyPoll);
+        mBusyPollOption = option;
+    }
+
     void run() const
     {
         asio::io_service::work worker(mIoContext);
+        if (mBusyPollOption)
+        {
+            runBusyPoll(*mBusyPollOption);
+            return;
+        }
         while (!mIoContext.stopped())
         {
             mIoContext.run();
@@ -48,17 +75,20 @@ public:
         return mIoContext;
     }
 
-    static std::shared_ptr<asio::steady_timer> RunAfter(asio::io_context& context, std::chrono::nanoseconds timeout, std::function<void(void)> callback)
+    // run task in context's thread, cross thread tasks are batched with one wakeup.
+    void submit(std::function<void(void)> task) const
     {
-        auto timer = std::make_shared<asio::steady_timer>(context);
-        timer->expires_from_now(timeout);
-        timer->async_wait([callback = std::move(callback), timer](const asio::error_code& ec) {
-            if (!ec)
-            {
-                callback();
-            }
-        });
-        return timer;
+        SubmissionQueue::Get(mIoContext).submit(std::move(task));
+    }
+
+    static WheelTimer::Ptr RunAfter(asio::io_context& context, std::chrono::nanoseconds timeout, std::function<void(void)> callback)
+    {
+        return TimerWheel::Get(context).runAfter(timeout, std::move(callback));
+    }
+
+    static WheelTimer::Ptr RunEvery(asio::io_context& context, std::chrono::nanoseconds period, std::function<void(void)> callback)
+    {
+        return TimerWheel::Get(context).runEvery(period, std::move(callback));
     }
 
     auto runAfter(std::chrono::nanoseconds timeout, std::function<void(void)> callback) const
@@ -66,9 +96,50 @@ public:
         return RunAfter(mIoContext, timeout, std::move(callback));
     }
 
+    auto runEvery(std::chrono::nanoseconds period, std::function<void(void)> callback) const
+    {
+        return RunEvery(mIoContext, period, std::move(callback));
+    }
+
+private:
+    void runBusyPoll(const BusyPollOption& option) const
+    {
+        using Clock = std::chrono::steady_clock;
+
+        auto spinBudget = option.maxSpin;
+        while (!mIoContext.stopped())
+        {
+            auto lastEventTime = Clock::now();
+            while (!mIoContext.stopped() && Clock::now() - lastEventTime < spinBudget)
+            {
+                if (mIoContext.poll() > 0)
+                {
+                    lastEventTime = Clock::now();
+                }
+            }
+
+            // no event in the budget, park in epoll_wait.
+            const auto parkTime = Clock::now();
+            mIoContext.run_one();
+            const auto parkedTime = Clock::now() - parkTime;
+
+            // the event would have been caught by spinning a little longer, so grow budget,
+            // otherwise the spin was wasted, shrink it.
+            if (parkedTime < option.maxSpin)
+            {
+                spinBudget = std::min<std::chrono::microseconds>(spinBudget * 2, option.maxSpin);
+            }
+            else
+            {
+                spinBudget = std::max<std::chrono::microseconds>(spinBudget / 2, option.minSpin);
+            }
+        }
+    }
+
 private:
     std::shared_ptr<asio::io_context> mTrickyIoContext;
     asio::io_context& mIoContext;
+    std::optional<BusyPollOption> mBusyPollOption;
 
     friend IoContextThread;
 };
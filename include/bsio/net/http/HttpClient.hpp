@@ -0,0 +1,628 @@
+#pragma once
+
+#include <algorithm>
+#include <asio.hpp>
+#include <bsio/net/IoContextProvider.hpp>
+#include <bsio/net/SendableMsg.hpp>
+#include <bsio/net/TcpConnector.hpp>
+#include <bsio/net/TcpSession.hpp>
+#include <bsio/net/TimerWheel.hpp>
+#include <bsio/net/http/HttpFormat.hpp>
+#include <bsio/net/http/HttpHeaders.hpp>
+#include <bsio/net/http/HttpParser.hpp>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace bsio::net::http {
+
+// a response received by HttpClient, the headers are views of the response.
+class HttpClientResponse : private asio::noncopyable
+{
+public:
+    using Ptr = std::shared_ptr<const HttpClientResponse>;
+
+    explicit HttpClientResponse(const HTTPParser& parser)
+        : mStatusCode(parser.getStatusCode()),
+          mKeepAlive(parser.isKeepAlive()),
+          mBody(parser.body())
+    {
+        size_t len = 0;
+        for (const auto& header : parser.headers())
+        {
+            len += header.name.size() + header.value.size();
+        }
+        mHeadText.reserve(len);
+        for (const auto& header : parser.headers())
+        {
+            mHeadText.append(header.name).append(header.value);
+        }
+        size_t pos = 0;
+        for (const auto& header : parser.headers())
+        {
+            const std::string_view text = mHeadText;
+            mHeaders.add(text.substr(pos, header.name.size()),
+                         text.substr(pos + header.name.size(), header.value.size()));
+            pos += header.name.size() + header.value.size();
+        }
+    }
+
+    int statusCode() const
+    {
+        return mStatusCode;
+    }
+
+    bool isKeepAlive() const
+    {
+        return mKeepAlive;
+    }
+
+    const HttpHeaders& headers() const
+    {
+        return mHeaders;
+    }
+
+    // the value of header, name is case-insensitive.
+    std::string_view header(std::string_view name) const
+    {
+        return mHeaders.find(name);
+    }
+
+    std::string_view header(HttpField field) const
+    {
+        return mHeaders.get(field);
+    }
+
+    const std::string& body() const
+    {
+        return mBody;
+    }
+
+private:
+    const int mStatusCode;
+    const bool mKeepAlive;
+    std::string mHeadText;
+    HttpHeaders mHeaders;
+    const std::string mBody;
+};
+
+struct HttpClientOptions {
+    // connections to one endpoint, including the connecting ones
+    size_t maxConnectionsPerHost = 8;
+    // idle connections kept for one endpoint, the others are closed when they become idle
+    size_t maxIdleConnectionsPerHost = 4;
+    // an idle connection is closed after it, zero means never
+    std::chrono::nanoseconds idleTimeout = std::chrono::seconds(60);
+    std::chrono::nanoseconds connectTimeout = std::chrono::seconds(5);
+    // requests in flight on one connection, 1 disables pipelining.
+    // only GET, HEAD, PUT and DELETE are pipelined.
+    size_t pipelineDepth = 1;
+    // requests waiting for a connection to one endpoint, zero means unlimited
+    size_t maxQueuedRequests = 0;
+    size_t recvBufferSize = 64 * 1024;
+};
+
+// sends requests over keep-alive connections pooled per endpoint. a request is sent on an idle
+// connection, pipelined on a busy one if enabled, or on a new connection while the endpoint
+// has less than maxConnectionsPerHost, otherwise it's queued until a connection is free.
+// requests failed because a reused connection is closed before the response begins are
+// sent again once if they are idempotent. callbacks are called in io threads.
+class HttpClient : public std::enable_shared_from_this<HttpClient>,
+                   private asio::noncopyable
+{
+public:
+    using Ptr = std::shared_ptr<HttpClient>;
+    // response is nullptr if ec is set.
+    using ResponseCallback = std::function<void(std::error_code ec, HttpClientResponse::Ptr response)>;
+
+    static Ptr Make(IoContextProvider::Ptr ioContextProvider, HttpClientOptions options = HttpClientOptions())
+    {
+        class make_shared_enabler : public HttpClient
+        {
+        public:
+            make_shared_enabler(IoContextProvider::Ptr ioContextProvider, HttpClientOptions options)
+                : HttpClient(std::move(ioContextProvider), options)
+            {}
+        };
+
+        return std::make_shared<make_shared_enabler>(std::move(ioContextProvider), options);
+    }
+
+    // connections are closed, the requests not answered are dropped.
+    virtual ~HttpClient()
+    {
+        for (auto& [endpoint, host] : mHosts)
+        {
+            for (const auto& connection : host.connections)
+            {
+                if (connection->session != nullptr)
+                {
+                    connection->session->close();
+                }
+            }
+        }
+    }
+
+    // the callback is called with asio::error::no_buffer_space in this thread if the queue is full.
+    void request(const asio::ip::tcp::endpoint& endpoint, const HttpRequest& request, ResponseCallback callback)
+    {
+        const auto method = request.getMethod();
+        const auto idempotent = method != HttpRequest::HTTP_METHOD::HTTP_METHOD_POST;
+        Actions actions;
+        {
+            std::lock_guard<std::mutex> lck(mGuard);
+            auto& host = mHosts[endpoint];
+            if (mOptions.maxQueuedRequests > 0 && host.pending.size() >= mOptions.maxQueuedRequests)
+            {
+                actions.completions.emplace_back(std::move(callback), asio::error::no_buffer_space, nullptr);
+            }
+            else
+            {
+                host.pending.push_back(Request{MakeStringMsg(request.getResult()), std::move(callback), method, idempotent, false});
+                dispatchLocked(endpoint, host, actions);
+            }
+        }
+        runActions(actions);
+    }
+
+    // the future throws std::system_error if the request failed.
+    std::future<HttpClientResponse::Ptr> request(const asio::ip::tcp::endpoint& endpoint, const HttpRequest& request)
+    {
+        auto promise = std::make_shared<std::promise<HttpClientResponse::Ptr>>();
+        auto future = promise->get_future();
+        this->request(endpoint, request, [promise](std::error_code ec, HttpClientResponse::Ptr response) {
+            if (ec)
+            {
+                promise->set_exception(std::make_exception_ptr(std::system_error(ec)));
+                return;
+            }
+            promise->set_value(std::move(response));
+        });
+        return future;
+    }
+
+    // established and connecting connections to endpoint.
+    size_t connectionNum(const asio::ip::tcp::endpoint& endpoint) const
+    {
+        std::lock_guard<std::mutex> lck(mGuard);
+        const auto it = mHosts.find(endpoint);
+        return it != mHosts.end() ? it->second.connections.size() : 0;
+    }
+
+protected:
+    HttpClient(IoContextProvider::Ptr ioContextProvider, HttpClientOptions options)
+        : mConnector(std::move(ioContextProvider)),
+          mOptions(options)
+    {
+        if (mOptions.maxConnectionsPerHost == 0)
+        {
+            throw std::runtime_error("max connections per host is 0");
+        }
+        if (mOptions.pipelineDepth == 0)
+        {
+            mOptions.pipelineDepth = 1;
+        }
+    }
+
+private:
+    struct Request {
+        SendableMsg::Ptr msg;
+        ResponseCallback callback;
+        HttpRequest::HTTP_METHOD method;
+        bool idempotent;
+        bool retried;
+    };
+
+    struct Connection {
+        // nullptr while connecting
+        TcpSession::Ptr session;
+        asio::io_context* ioContext = nullptr;
+        HTTPParser parser{HTTP_RESPONSE};
+        std::deque<Request> inflight;
+        // bytes of the response of inflight.front() are received, only io thread
+        bool responseStarted = false;
+        size_t servedNum = 0;
+        bool closing = false;
+        WheelTimer::Ptr idleTimer;
+    };
+    using ConnectionPtr = std::shared_ptr<Connection>;
+
+    struct Host {
+        std::vector<ConnectionPtr> connections;
+        size_t connectingNum = 0;
+        std::deque<Request> pending;
+    };
+
+    // done by the caller of a locked function after unlocking, they may reenter the client.
+    struct Actions {
+        std::vector<std::tuple<ResponseCallback, std::error_code, HttpClientResponse::Ptr>> completions;
+        std::vector<TcpSession::Ptr> closes;
+        std::vector<std::pair<asio::ip::tcp::endpoint, ConnectionPtr>> connects;
+    };
+
+    void runActions(Actions& actions)
+    {
+        for (const auto& session : actions.closes)
+        {
+            session->close();
+        }
+        for (auto& [endpoint, connection] : actions.connects)
+        {
+            connect(endpoint, connection);
+        }
+        for (auto& [callback, ec, response] : actions.completions)
+        {
+            if (callback != nullptr)
+            {
+                callback(ec, std::move(response));
+            }
+        }
+    }
+
+    static bool canAccept(const Connection& connection, const Request& request, size_t pipelineDepth)
+    {
+        if (connection.session == nullptr || connection.closing)
+        {
+            return false;
+        }
+        return connection.inflight.empty() ||
+               (request.idempotent && connection.inflight.size() < pipelineDepth && connection.inflight.back().idempotent);
+    }
+
+    void dispatchLocked(const asio::ip::tcp::endpoint& endpoint, Host& host, Actions& actions)
+    {
+        while (!host.pending.empty())
+        {
+            auto& request = host.pending.front();
+            // idle connections first, then the least loaded one
+            ConnectionPtr target;
+            for (const auto& connection : host.connections)
+            {
+                if (canAccept(*connection, request, mOptions.pipelineDepth) &&
+                    (target == nullptr || connection->inflight.size() < target->inflight.size()))
+                {
+                    target = connection;
+                }
+            }
+            if (target != nullptr)
+            {
+                if (target->idleTimer != nullptr)
+                {
+                    target->idleTimer->cancel();
+                    target->idleTimer = nullptr;
+                }
+                // sent under the lock, so the order of bytes is the order of inflight
+                target->session->send(request.msg);
+                target->inflight.push_back(std::move(request));
+                host.pending.pop_front();
+                continue;
+            }
+            if (host.connections.size() < mOptions.maxConnectionsPerHost && host.connectingNum < host.pending.size())
+            {
+                auto connection = std::make_shared<Connection>();
+                host.connections.push_back(connection);
+                host.connectingNum++;
+                actions.connects.emplace_back(endpoint, std::move(connection));
+                continue;
+            }
+            break;
+        }
+    }
+
+    void connect(const asio::ip::tcp::endpoint& endpoint, const ConnectionPtr& connection)
+    {
+        std::weak_ptr<HttpClient> weakClient = shared_from_this();
+        std::weak_ptr<Connection> weakConnection = connection;
+        mConnector.asyncConnect(
+                endpoint,
+                mOptions.connectTimeout,
+                [weakClient, weakConnection, endpoint](asio::ip::tcp::socket socket) {
+                    const auto client = weakClient.lock();
+                    const auto connection = weakConnection.lock();
+                    if (client == nullptr || connection == nullptr)
+                    {
+                        return;
+                    }
+                    client->onConnected(endpoint, connection, std::move(socket));
+                },
+                [weakClient, weakConnection, endpoint]() {
+                    const auto client = weakClient.lock();
+                    const auto connection = weakConnection.lock();
+                    if (client == nullptr || connection == nullptr)
+                    {
+                        return;
+                    }
+                    client->onConnectFailed(endpoint, connection);
+                },
+                {});
+    }
+
+    void onConnected(const asio::ip::tcp::endpoint& endpoint, const ConnectionPtr& connection, asio::ip::tcp::socket socket)
+    {
+        std::weak_ptr<HttpClient> weakClient = shared_from_this();
+        std::weak_ptr<Connection> weakConnection = connection;
+        auto& ioContext = static_cast<asio::io_context&>(socket.get_executor().context());
+        auto session = TcpSession::Make(
+                std::move(socket),
+                mOptions.recvBufferSize,
+                [weakClient, weakConnection, endpoint](const TcpSession::Ptr& session, bsio::base::BasePacketReader& reader) {
+                    const auto client = weakClient.lock();
+                    const auto connection = weakConnection.lock();
+                    if (client == nullptr || connection == nullptr)
+                    {
+                        session->close();
+                        return;
+                    }
+                    client->onData(endpoint, connection, session, reader);
+                },
+                [weakClient, weakConnection, endpoint](const TcpSession::Ptr&) {
+                    const auto client = weakClient.lock();
+                    const auto connection = weakConnection.lock();
+                    if (client != nullptr && connection != nullptr)
+                    {
+                        client->onClosed(endpoint, connection);
+                    }
+                },
+                [weakClient, weakConnection, endpoint](const TcpSession::Ptr& session) {
+                    // the response without length ends at eof
+                    const auto client = weakClient.lock();
+                    const auto connection = weakConnection.lock();
+                    if (client != nullptr && connection != nullptr && connection->responseStarted)
+                    {
+                        connection->parser.tryParse(nullptr, 0);
+                        if (connection->parser.isCompleted())
+                        {
+                            connection->responseStarted = false;
+                            client->onResponse(endpoint, connection);
+                        }
+                    }
+                    session->close();
+                });
+
+        Actions actions;
+        {
+            std::lock_guard<std::mutex> lck(mGuard);
+            auto& host = mHosts[endpoint];
+            // connected after the timeout failed it
+            if (std::find(host.connections.begin(), host.connections.end(), connection) == host.connections.end())
+            {
+                actions.closes.push_back(session);
+            }
+            else
+            {
+                host.connectingNum--;
+                connection->session = session;
+                connection->ioContext = &ioContext;
+                dispatchLocked(endpoint, host, actions);
+                if (connection->inflight.empty())
+                {
+                    idleLocked(host, connection, actions);
+                }
+            }
+        }
+        session->startRecv();
+        runActions(actions);
+    }
+
+    void onConnectFailed(const asio::ip::tcp::endpoint& endpoint, const ConnectionPtr& connection)
+    {
+        Actions actions;
+        {
+            std::lock_guard<std::mutex> lck(mGuard);
+            auto& host = mHosts[endpoint];
+            if (!removeLocked(host, connection))
+            {
+                return;
+            }
+            host.connectingNum--;
+            // the requests can't be sent if no connection is left
+            if (host.connections.empty())
+            {
+                for (auto& request : host.pending)
+                {
+                    actions.completions.emplace_back(std::move(request.callback), asio::error::not_connected, nullptr);
+                }
+                host.pending.clear();
+            }
+        }
+        runActions(actions);
+    }
+
+    void onData(const asio::ip::tcp::endpoint& endpoint,
+                const ConnectionPtr& connection,
+                const TcpSession::Ptr& session,
+                bsio::base::BasePacketReader& reader)
+    {
+        const char* buffer = reader.begin();
+        size_t leftLen = reader.size();
+        while (leftLen > 0)
+        {
+            if (!connection->responseStarted)
+            {
+                connection->responseStarted = true;
+                connection->parser.setSkipBody(isHeadResponse(*connection));
+            }
+            const auto retLen = connection->parser.tryParse(buffer, leftLen);
+            buffer += retLen;
+            leftLen -= retLen;
+            if (connection->parser.hasError())
+            {
+                session->close();
+                break;
+            }
+            if (!connection->parser.isCompleted())
+            {
+                break;
+            }
+            connection->responseStarted = false;
+            if (!onResponse(endpoint, connection))
+            {
+                break;
+            }
+        }
+
+        reader.addPos(reader.size() - leftLen);
+        reader.savePos();
+    }
+
+    // the response of inflight.front() is the next one to receive.
+    bool isHeadResponse(const Connection& connection) const
+    {
+        std::lock_guard<std::mutex> lck(mGuard);
+        return !connection.inflight.empty() &&
+               connection.inflight.front().method == HttpRequest::HTTP_METHOD::HTTP_METHOD_HEAD;
+    }
+
+    // return false if the connection is closing.
+    bool onResponse(const asio::ip::tcp::endpoint& endpoint, const ConnectionPtr& connection)
+    {
+        auto response = std::make_shared<const HttpClientResponse>(connection->parser);
+        Actions actions;
+        bool closing = false;
+        {
+            std::lock_guard<std::mutex> lck(mGuard);
+            auto& host = mHosts[endpoint];
+            if (connection->inflight.empty())
+            {
+                // a response without request
+                connection->closing = true;
+                actions.closes.push_back(connection->session);
+            }
+            else
+            {
+                actions.completions.emplace_back(std::move(connection->inflight.front().callback), std::error_code(), std::move(response));
+                connection->inflight.pop_front();
+                connection->servedNum++;
+                if (!connection->parser.isKeepAlive() && !connection->closing)
+                {
+                    connection->closing = true;
+                    actions.closes.push_back(connection->session);
+                }
+            }
+            closing = connection->closing;
+            dispatchLocked(endpoint, host, actions);
+            if (!closing && connection->inflight.empty())
+            {
+                idleLocked(host, connection, actions);
+            }
+        }
+        runActions(actions);
+        return !closing;
+    }
+
+    void onClosed(const asio::ip::tcp::endpoint& endpoint, const ConnectionPtr& connection)
+    {
+        Actions actions;
+        {
+            std::lock_guard<std::mutex> lck(mGuard);
+            auto& host = mHosts[endpoint];
+            if (!removeLocked(host, connection))
+            {
+                return;
+            }
+            if (connection->idleTimer != nullptr)
+            {
+                connection->idleTimer->cancel();
+                connection->idleTimer = nullptr;
+            }
+            // a reused connection may be closed by server while the requests are sent,
+            // the ones not answered at all are sent again.
+            const auto retry = connection->servedNum > 0 && !connection->responseStarted;
+            std::vector<Request> retries;
+            for (auto& request : connection->inflight)
+            {
+                if (retry && request.idempotent && !request.retried)
+                {
+                    request.retried = true;
+                    retries.push_back(std::move(request));
+                }
+                else
+                {
+                    actions.completions.emplace_back(std::move(request.callback), asio::error::connection_reset, nullptr);
+                }
+            }
+            connection->inflight.clear();
+            host.pending.insert(host.pending.begin(),
+                                std::make_move_iterator(retries.begin()),
+                                std::make_move_iterator(retries.end()));
+            dispatchLocked(endpoint, host, actions);
+        }
+        runActions(actions);
+    }
+
+    // closes the connection if there are enough idle ones, else closes it after idle timeout.
+    void idleLocked(Host& host, const ConnectionPtr& connection, Actions& actions)
+    {
+        size_t idleNum = 0;
+        for (const auto& other : host.connections)
+        {
+            if (other->session != nullptr && !other->closing && other->inflight.empty())
+            {
+                idleNum++;
+            }
+        }
+        if (idleNum > mOptions.maxIdleConnectionsPerHost)
+        {
+            connection->closing = true;
+            actions.closes.push_back(connection->session);
+            return;
+        }
+        if (mOptions.idleTimeout.count() <= 0 || connection->idleTimer != nullptr)
+        {
+            return;
+        }
+
+        std::weak_ptr<HttpClient> weakClient = shared_from_this();
+        std::weak_ptr<Connection> weakConnection = connection;
+        connection->idleTimer = TimerWheel::Get(*connection->ioContext).runAfter(mOptions.idleTimeout, [weakClient, weakConnection]() {
+            const auto client = weakClient.lock();
+            const auto connection = weakConnection.lock();
+            if (client == nullptr || connection == nullptr)
+            {
+                return;
+            }
+            TcpSession::Ptr session;
+            {
+                std::lock_guard<std::mutex> lck(client->mGuard);
+                if (connection->closing || !connection->inflight.empty())
+                {
+                    return;
+                }
+                connection->closing = true;
+                connection->idleTimer = nullptr;
+                session = connection->session;
+            }
+            session->close();
+        });
+    }
+
+    static bool removeLocked(Host& host, const ConnectionPtr& connection)
+    {
+        const auto it = std::find(host.connections.begin(), host.connections.end(), connection);
+        if (it == host.connections.end())
+        {
+            return false;
+        }
+        host.connections.erase(it);
+        return true;
+    }
+
+private:
+    TcpConnector mConnector;
+    HttpClientOptions mOptions;
+
+    mutable std::mutex mGuard;
+    std::map<asio::ip::tcp::endpoint, Host> mHosts;
+};
+
+}// namespace bsio::net::http
@@ -3,6 +3,7 @@
 #include <array>
 #include <cassert>
 #include <map>
+#include <bsio/net/http/HttpStatus.hpp>
 #include <string>
 
 namespace bsio::net::http {
@@ -52,10 +53,15 @@ public:
     void setMethod(HTTP_METHOD protocol)
     {
         mMethod = protocol;
-        assert(mMethod > HTTP_METHOD::HTTP_METHOD_HEAD &&
+        assert(mMethod >= HTTP_METHOD::HTTP_METHOD_HEAD &&
                mMethod < HTTP_METHOD::HTTP_METHOD_MAX);
     }
 
+    HTTP_METHOD getMethod() const
+    {
+        return mMethod;
+    }
+
     void setHost(const std::string& host)
     {
         addHeadValue("Host", host);
@@ -163,6 +169,12 @@ public:
         mStatus = status;
     }
 
+    // any code of HttpStatus.hpp.
+    void setStatus(int status)
+    {
+        mStatus = static_cast<HTTP_RESPONSE_STATUS>(status);
+    }
+
     void setContentType(const std::string& v)
     {
         addHeadValue("Content-Type", v);
@@ -191,15 +203,8 @@ public:
         std::string ret = "HTTP/1.1 ";
 
         ret += std::to_string(static_cast<int>(mStatus));
-        switch (mStatus)
-        {
-            case HTTP_RESPONSE_STATUS::OK:
-                ret += " OK";
-                break;
-            default:
-                ret += "UNKNOWN";
-                break;
-        }
+        ret += " ";
+        ret += HttpStatusReason(static_cast<int>(mStatus));
 
         ret += "\r\n";
 
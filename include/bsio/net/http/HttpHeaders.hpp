@@ -0,0 +1,338 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace bsio::net::http {
+
+// well-known headers, recognized when they are parsed.
+enum class HttpField : uint8_t
+{
+    Unknown,
+    Host,
+    ContentLength,
+    ContentType,
+    Connection,
+    Upgrade,
+    SecWebSocketKey,
+    SecWebSocketVersion,
+    SecWebSocketProtocol,
+    SecWebSocketExtensions,
+    SecWebSocketAccept,
+    TransferEncoding,
+    Accept,
+    AcceptEncoding,
+    AcceptLanguage,
+    UserAgent,
+    Cookie,
+    SetCookie,
+    IfNoneMatch,
+    IfModifiedSince,
+    Range,
+    IfRange,
+    Authorization,
+    Expect,
+    KeepAlive,
+    Date,
+    ETag,
+    LastModified,
+    Location,
+    Server,
+    CacheControl,
+    ContentEncoding,
+    ContentRange,
+    AcceptRanges,
+    Origin,
+    Referer,
+    XForwardedFor,
+    Count,
+};
+
+// lowercase names indexed by HttpField.
+inline constexpr std::array<std::string_view, static_cast<size_t>(HttpField::Count)> HttpFieldNames = {
+        "",
+        "host",
+        "content-length",
+        "content-type",
+        "connection",
+        "upgrade",
+        "sec-websocket-key",
+        "sec-websocket-version",
+        "sec-websocket-protocol",
+        "sec-websocket-extensions",
+        "sec-websocket-accept",
+        "transfer-encoding",
+        "accept",
+        "accept-encoding",
+        "accept-language",
+        "user-agent",
+        "cookie",
+        "set-cookie",
+        "if-none-match",
+        "if-modified-since",
+        "range",
+        "if-range",
+        "authorization",
+        "expect",
+        "keep-alive",
+        "date",
+        "etag",
+        "last-modified",
+        "location",
+        "server",
+        "cache-control",
+        "content-encoding",
+        "content-range",
+        "accept-ranges",
+        "origin",
+        "referer",
+        "x-forwarded-for",
+};
+
+struct HttpHeader {
+    std::string_view name;
+    std::string_view value;
+    HttpField field = HttpField::Unknown;
+};
+
+constexpr char ToLower(char c) noexcept
+{
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c | 0x20) : c;
+}
+
+// names are compared case-insensitively, as defined by RFC 7230.
+constexpr bool HeaderNameEquals(std::string_view a, std::string_view b) noexcept
+{
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        if (ToLower(a[i]) != ToLower(b[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+namespace internal {
+
+constexpr size_t FieldTableSize = 128;
+
+// the length, first and last char are unique among the well-known names.
+constexpr size_t FieldHash(std::string_view name) noexcept
+{
+    return (name.size() +
+            static_cast<size_t>(ToLower(name.front())) * 7 +
+            static_cast<size_t>(ToLower(name.back())) * 31) &
+           (FieldTableSize - 1);
+}
+
+constexpr std::array<HttpField, FieldTableSize> MakeFieldTable()
+{
+    std::array<HttpField, FieldTableSize> table{};
+    for (size_t i = 1; i < HttpFieldNames.size(); i++)
+    {
+        table[FieldHash(HttpFieldNames[i])] = static_cast<HttpField>(i);
+    }
+    return table;
+}
+
+constexpr bool FieldHashIsPerfect()
+{
+    std::array<bool, FieldTableSize> used{};
+    for (size_t i = 1; i < HttpFieldNames.size(); i++)
+    {
+        const auto hash = FieldHash(HttpFieldNames[i]);
+        if (used[hash])
+        {
+            return false;
+        }
+        used[hash] = true;
+    }
+    return true;
+}
+
+static_assert(FieldHashIsPerfect(), "hash of well-known header names collides");
+
+inline constexpr auto FieldTable = MakeFieldTable();
+
+}// namespace internal
+
+// one table load and one compare.
+constexpr HttpField HttpFieldOf(std::string_view name) noexcept
+{
+    if (name.empty())
+    {
+        return HttpField::Unknown;
+    }
+    const auto field = internal::FieldTable[internal::FieldHash(name)];
+    if (field != HttpField::Unknown && HeaderNameEquals(name, HttpFieldNames[static_cast<size_t>(field)]))
+    {
+        return field;
+    }
+    return HttpField::Unknown;
+}
+
+// flat list of headers referencing memory owned by the parser or the receive buffer,
+// most requests fit in the inline storage, so parsing them doesn't allocate.
+class HttpHeaders
+{
+public:
+    static constexpr size_t InlineCapacity = 32;
+
+    void add(std::string_view name, std::string_view value)
+    {
+        const auto field = HttpFieldOf(name);
+        auto& index = mFieldIndexes[static_cast<size_t>(field)];
+        if (field != HttpField::Unknown && index == 0)
+        {
+            index = static_cast<uint32_t>(mSize + 1);
+        }
+
+        if (mSize < InlineCapacity)
+        {
+            mInline[mSize++] = HttpHeader{name, value, field};
+            return;
+        }
+        if (mSize == InlineCapacity)
+        {
+            mOverflow.assign(mInline.begin(), mInline.end());
+        }
+        mOverflow.push_back(HttpHeader{name, value, field});
+        mSize++;
+    }
+
+    void clear() noexcept
+    {
+        mSize = 0;
+        mOverflow.clear();
+        mFieldIndexes.fill(0);
+    }
+
+    // the value of first header of field, or an empty view.
+    std::string_view get(HttpField field) const noexcept
+    {
+        const auto header = findHeader(field);
+        return header != nullptr ? header->value : std::string_view();
+    }
+
+    bool contains(HttpField field) const noexcept
+    {
+        return findHeader(field) != nullptr;
+    }
+
+    // the value of first header named name, or an empty view.
+    std::string_view find(std::string_view name) const noexcept
+    {
+        const auto header = findHeader(name);
+        return header != nullptr ? header->value : std::string_view();
+    }
+
+    bool contains(std::string_view name) const noexcept
+    {
+        return findHeader(name) != nullptr;
+    }
+
+    size_t size() const noexcept
+    {
+        return mSize;
+    }
+
+    bool empty() const noexcept
+    {
+        return mSize == 0;
+    }
+
+    HttpHeader& back() noexcept
+    {
+        return data()[mSize - 1];
+    }
+
+    const HttpHeader* begin() const noexcept
+    {
+        return data();
+    }
+
+    const HttpHeader* end() const noexcept
+    {
+        return data() + mSize;
+    }
+
+    const HttpHeader& operator[](size_t index) const noexcept
+    {
+        return data()[index];
+    }
+
+    // move views inside [from, from + len) to the same offsets of to.
+    void rebase(const char* from, size_t len, const char* to) noexcept
+    {
+        for (size_t i = 0; i < mSize; i++)
+        {
+            auto& header = data()[i];
+            header.name = Rebase(header.name, from, len, to);
+            header.value = Rebase(header.value, from, len, to);
+        }
+    }
+
+    static std::string_view Rebase(std::string_view view, const char* from, size_t len, const char* to) noexcept
+    {
+        if (view.data() < from || view.data() >= from + len)
+        {
+            return view;
+        }
+        return std::string_view(to + (view.data() - from), view.size());
+    }
+
+private:
+    const HttpHeader* findHeader(HttpField field) const noexcept
+    {
+        const auto index = mFieldIndexes[static_cast<size_t>(field)];
+        if (field == HttpField::Unknown || index == 0)
+        {
+            return nullptr;
+        }
+        return &data()[index - 1];
+    }
+
+    // well-known names are found by index, others by scanning.
+    const HttpHeader* findHeader(std::string_view name) const noexcept
+    {
+        if (const auto field = HttpFieldOf(name); field != HttpField::Unknown)
+        {
+            return findHeader(field);
+        }
+        for (const auto& header : *this)
+        {
+            if (header.field == HttpField::Unknown && HeaderNameEquals(header.name, name))
+            {
+                return &header;
+            }
+        }
+        return nullptr;
+    }
+
+    HttpHeader* data() noexcept
+    {
+        return mSize <= InlineCapacity ? mInline.data() : mOverflow.data();
+    }
+
+    const HttpHeader* data() const noexcept
+    {
+        return mSize <= InlineCapacity ? mInline.data() : mOverflow.data();
+    }
+
+private:
+    size_t mSize = 0;
+    // 1 + position of the first header of each field, 0 if absent
+    std::array<uint32_t, static_cast<size_t>(HttpField::Count)> mFieldIndexes{};
+    std::array<HttpHeader, InlineCapacity> mInline;
+    std::vector<HttpHeader> mOverflow;
+};
+
+}// namespace bsio::net::http
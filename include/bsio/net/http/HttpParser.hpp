@@ -1,10 +1,13 @@
 #pragma once
 
+#include <bsio/net/http/HttpHeaders.hpp>
 #include <bsio/net/http/WebSocketFormat.hpp>
 #include <cassert>
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 
 #include "http_parser.h"
 
@@ -16,9 +19,16 @@ class HTTPParser
 {
 public:
     using Ptr = std::shared_ptr<HTTPParser>;
-
-    explicit HTTPParser(http_parser_type parserType)
-        : mParserType(parserType)
+    using HeadersCallback = std::function<void(const HTTPParser&)>;
+    // return false to pause parsing after the chunk, the rest stays in receive buffer.
+    using BodyChunkCallback = std::function<bool(const HTTPParser&, std::string_view chunk)>;
+
+    // in zero copy mode, the url, headers and body are views of the receive buffer, or of the
+    // storage of parser if the message is split into several reads, they are valid only in
+    // HttpParserCallback. the string accessors such as getPath() and getValue() are empty.
+    explicit HTTPParser(http_parser_type parserType, bool zeroCopy = false)
+        : mParserType(parserType),
+          mZeroCopy(zeroCopy)
     {
         mLastWasValue = true;
 
@@ -88,16 +98,16 @@ public:
     }
 
     // TODO::support value array
+    // keys are case-insensitive.
     bool hasEntry(const std::string& key,
                   const std::string& value) const
     {
-        const auto it = mHeadValues.find(key);
-        return it != mHeadValues.end() && value == it->second;
+        return hasKey(key) && mHeaders.find(key) == value;
     }
 
     bool hasKey(const std::string& key) const
     {
-        return mHeadValues.find(key) != mHeadValues.end();
+        return mHeaders.contains(key);
     }
 
     const std::string& getValue(const std::string& key) const
@@ -109,10 +119,14 @@ public:
         {
             return (*it).second;
         }
-        else
+        for (const auto& [name, value] : mHeadValues)
         {
-            return emptystr;
+            if (HeaderNameEquals(name, key))
+            {
+                return value;
+            }
         }
+        return emptystr;
     }
 
     const std::string& getBody() const
@@ -145,14 +159,84 @@ public:
         return mISCompleted;
     }
 
+    // in streaming mode, body chunks are passed to callback rather than accumulated,
+    // headersCallback is called when the head is parsed, body() is empty.
+    void setBodyStreaming(HeadersCallback headersCallback, BodyChunkCallback bodyChunkCallback)
+    {
+        mHeadersCallback = std::move(headersCallback);
+        mBodyChunkCallback = std::move(bodyChunkCallback);
+    }
+
+    bool isStreaming() const
+    {
+        return mBodyChunkCallback != nullptr;
+    }
+
+    // the message in progress is invalid.
+    bool hasError() const
+    {
+        return HTTP_PARSER_ERRNO(&mParser) != HPE_OK && HTTP_PARSER_ERRNO(&mParser) != HPE_PAUSED;
+    }
+
+    bool isZeroCopy() const
+    {
+        return mZeroCopy;
+    }
+
+    // the view accessors work in both modes.
+
+    std::string_view url() const
+    {
+        return mUrlView;
+    }
+
+    std::string_view path() const
+    {
+        return mPathView;
+    }
+
+    std::string_view query() const
+    {
+        return mQueryView;
+    }
+
+    std::string_view status() const
+    {
+        return mStatusView;
+    }
+
+    std::string_view body() const
+    {
+        return mBodyOwned ? std::string_view(mBody) : mBodyView;
+    }
+
+    const HttpHeaders& headers() const
+    {
+        return mHeaders;
+    }
+
+    // the value of header, name is case-insensitive.
+    std::string_view header(std::string_view name) const
+    {
+        return mHeaders.find(name);
+    }
+
+    std::string_view header(HttpField field) const
+    {
+        return mHeaders.get(field);
+    }
+
 private:
     void clearParse()
     {
         mMethod = -1;
         mIsUpgrade = false;
         mIsWebSocket = false;
+        mIsKeepAlive = false;
         mISCompleted = false;
         mLastWasValue = true;
+        mHeadersCompleted = false;
+        mBodyOwned = false;
         mUrl.clear();
         mQuery.clear();
         mBody.clear();
@@ -161,22 +245,130 @@ private:
         mCurrentValue.clear();
         mHeadValues.clear();
         mPath.clear();
+        mUrlView = {};
+        mPathView = {};
+        mQueryView = {};
+        mStatusView = {};
+        mBodyView = {};
+        mCurrentFieldView = {};
+        mHeaders.clear();
+    }
+
+    // the response of HEAD request has no body even if it has Content-Length,
+    // set before the response is parsed.
+    void setSkipBody(bool skipBody)
+    {
+        mSkipBody = skipBody;
     }
 
+    // parse one message at most, return the number of bytes consumed.
     size_t tryParse(const char* buffer, size_t len)
     {
-        const size_t nparsed = http_parser_execute(&mParser, &mSettings, buffer, len);
         if (mISCompleted)
         {
-            mIsUpgrade = mParser.upgrade;
-            mIsWebSocket = mIsUpgrade && hasEntry("Upgrade", "websocket");
-            mMethod = mParser.method;
+            // the previous message has been handled
+            mISCompleted = false;
+            mPending.clear();
+        }
+        else if (HTTP_PARSER_ERRNO(&mParser) == HPE_PAUSED)
+        {
+            // paused by body chunk callback
+            http_parser_pause(&mParser, 0);
+        }
+
+        const auto nparsed = mZeroCopy ? parseZeroCopy(buffer, len) : execute(buffer, len);
+        if (mISCompleted)
+        {
             http_parser_init(&mParser, mParserType);
         }
 
         return nparsed;
     }
 
+    size_t execute(const char* buffer, size_t len)
+    {
+        return http_parser_execute(&mParser, &mSettings, buffer, len);
+    }
+
+    // the head of message is parsed from contiguous memory, so every field and value is one view.
+    // if the head is split, it's kept in mPending and parsed again from the beginning when more
+    // data arrives; after the head completed, the body is appended to mBody.
+    size_t parseZeroCopy(const char* buffer, size_t len)
+    {
+        if (mHeadersCompleted || (mPending.empty() && len > 0))
+        {
+            const auto nparsed = execute(buffer, len);
+            if (mISCompleted || hasError())
+            {
+                return nparsed;
+            }
+            if (!mHeadersCompleted)
+            {
+                mPending.assign(buffer, nparsed);
+                http_parser_init(&mParser, mParserType);
+                return nparsed;
+            }
+            if (mPending.empty())
+            {
+                // the head is in the receive buffer, which is consumed after return
+                mPending.assign(buffer, nparsed);
+                rebase(buffer, nparsed, mPending.data());
+            }
+            ownBody();
+            return nparsed;
+        }
+
+        const auto oldSize = mPending.size();
+        mPending.append(buffer, len);
+        const auto nparsed = execute(mPending.data(), mPending.size());
+        if (hasError())
+        {
+            return nparsed > oldSize ? nparsed - oldSize : 0;
+        }
+        if (!mISCompleted && !mHeadersCompleted)
+        {
+            http_parser_init(&mParser, mParserType);
+            return len;
+        }
+        if (!mISCompleted)
+        {
+            ownBody();
+        }
+        // the rest belongs to the next message
+        return nparsed - oldSize;
+    }
+
+    void rebase(const char* from, size_t len, const char* to)
+    {
+        mUrlView = HttpHeaders::Rebase(mUrlView, from, len, to);
+        mPathView = HttpHeaders::Rebase(mPathView, from, len, to);
+        mQueryView = HttpHeaders::Rebase(mQueryView, from, len, to);
+        mStatusView = HttpHeaders::Rebase(mStatusView, from, len, to);
+        mHeaders.rebase(from, len, to);
+    }
+
+    void ownBody()
+    {
+        if (!mBodyOwned)
+        {
+            mBody.assign(mBodyView.data(), mBodyView.size());
+            mBodyOwned = true;
+        }
+    }
+
+    // extend view if data follows it in the same buffer.
+    static void appendView(std::string_view& view, const char* at, size_t length)
+    {
+        if (!view.empty() && view.data() + view.size() == at)
+        {
+            view = std::string_view(view.data(), view.size() + length);
+        }
+        else
+        {
+            view = std::string_view(at, length);
+        }
+    }
+
 private:
     static int sChunkHeader(http_parser* hp)
     {
@@ -201,53 +393,92 @@ private:
     {
         HTTPParser* httpParser = (HTTPParser*) hp->data;
         httpParser->mISCompleted = true;
+        httpParser->mMethod = hp->method;
+        httpParser->mIsUpgrade = hp->upgrade;
+        httpParser->mIsWebSocket = hp->upgrade &&
+                                   HeaderNameEquals(httpParser->mHeaders.get(HttpField::Upgrade), "websocket");
+        // stop at the end of message, the next one in the buffer is parsed after callback.
+        http_parser_pause(hp, 1);
         return 0;
     }
 
     static int sHeadComplete(http_parser* hp)
     {
         HTTPParser* httpParser = (HTTPParser*) hp->data;
+        httpParser->mHeadersCompleted = true;
 
-        if (httpParser->mUrl.empty())
+        if (!httpParser->mZeroCopy)
         {
-            return 0;
+            // views of the owned strings, map nodes are never moved.
+            httpParser->mUrlView = httpParser->mUrl;
+            httpParser->mStatusView = httpParser->mStatus;
+            for (const auto& [name, value] : httpParser->mHeadValues)
+            {
+                httpParser->mHeaders.add(name, value);
+            }
         }
+        httpParser->mIsKeepAlive = http_should_keep_alive(hp) != 0;
 
+        if (!httpParser->mUrlView.empty() && !httpParser->parseUrl())
+        {
+            return -1;
+        }
+        if (httpParser->mHeadersCallback != nullptr)
+        {
+            httpParser->mHeadersCallback(*httpParser);
+        }
+
+        // 1 tells http_parser that the message has no body
+        return httpParser->mSkipBody ? 1 : 0;
+    }
+
+    bool parseUrl()
+    {
+        const auto url = mUrlView;
         struct http_parser_url u;
 
-        const int result = http_parser_parse_url(httpParser->mUrl.data(),
-                                                 httpParser->mUrl.size(),
+        const int result = http_parser_parse_url(url.data(),
+                                                 url.size(),
                                                  0,
                                                  &u);
         if (result != 0)
         {
-            return -1;
+            return false;
         }
 
         if (!(u.field_set & (1 << UF_PATH)))
         {
             fprintf(stderr,
-                    "\n\n*** failed to parse PATH in URL %s ***\n\n",
-                    httpParser->mUrl.c_str());
-            return -1;
+                    "\n\n*** failed to parse PATH in URL %.*s ***\n\n",
+                    static_cast<int>(url.size()),
+                    url.data());
+            return false;
         }
 
-        httpParser->mPath = std::string(
-                httpParser->mUrl.data() + u.field_data[UF_PATH].off,
-                u.field_data[UF_PATH].len);
+        mPathView = url.substr(u.field_data[UF_PATH].off, u.field_data[UF_PATH].len);
         if (u.field_set & (1 << UF_QUERY))
         {
-            httpParser->mQuery = std::string(
-                    httpParser->mUrl.data() + u.field_data[UF_QUERY].off,
-                    u.field_data[UF_QUERY].len);
+            mQueryView = url.substr(u.field_data[UF_QUERY].off, u.field_data[UF_QUERY].len);
+        }
+        if (!mZeroCopy)
+        {
+            mPath = mPathView;
+            mQuery = mQueryView;
+            mPathView = mPath;
+            mQueryView = mQuery;
         }
 
-        return 0;
+        return true;
     }
 
     static int sUrlHandle(http_parser* hp, const char* url, size_t length)
     {
         HTTPParser* httpParser = (HTTPParser*) hp->data;
+        if (httpParser->mZeroCopy)
+        {
+            appendView(httpParser->mUrlView, url, length);
+            return 0;
+        }
         httpParser->mUrl.append(url, length);
 
         return 0;
@@ -256,6 +487,16 @@ private:
     static int sHeadField(http_parser* hp, const char* at, size_t length)
     {
         HTTPParser* httpParser = (HTTPParser*) hp->data;
+        if (httpParser->mZeroCopy)
+        {
+            if (httpParser->mLastWasValue)
+            {
+                httpParser->mCurrentFieldView = {};
+            }
+            appendView(httpParser->mCurrentFieldView, at, length);
+            httpParser->mLastWasValue = false;
+            return 0;
+        }
         if (httpParser->mLastWasValue)
         {
             httpParser->mCurrentField.clear();
@@ -269,6 +510,19 @@ private:
     static int sHeadValue(http_parser* hp, const char* at, size_t length)
     {
         HTTPParser* httpParser = (HTTPParser*) hp->data;
+        if (httpParser->mZeroCopy)
+        {
+            if (httpParser->mLastWasValue && !httpParser->mHeaders.empty())
+            {
+                appendView(httpParser->mHeaders.back().value, at, length);
+            }
+            else
+            {
+                httpParser->mHeaders.add(httpParser->mCurrentFieldView, std::string_view(at, length));
+            }
+            httpParser->mLastWasValue = true;
+            return 0;
+        }
         auto& value = httpParser->mHeadValues[httpParser->mCurrentField];
         value.append(at, length);
         httpParser->mLastWasValue = true;
@@ -278,20 +532,48 @@ private:
     static int sStatusHandle(http_parser* hp, const char* at, size_t length)
     {
         HTTPParser* httpParser = (HTTPParser*) hp->data;
-        httpParser->mStatus.append(at, length);
         httpParser->mStatusCode = hp->status_code;
+        if (httpParser->mZeroCopy)
+        {
+            appendView(httpParser->mStatusView, at, length);
+            return 0;
+        }
+        httpParser->mStatus.append(at, length);
         return 0;
     }
 
     static int sBodyHandle(http_parser* hp, const char* at, size_t length)
     {
         HTTPParser* httpParser = (HTTPParser*) hp->data;
-        httpParser->mBody.append(at, length);
+        if (httpParser->mBodyChunkCallback != nullptr)
+        {
+            if (!httpParser->mBodyChunkCallback(*httpParser, std::string_view(at, length)))
+            {
+                http_parser_pause(hp, 1);
+            }
+            return 0;
+        }
+        if (!httpParser->mZeroCopy || httpParser->mBodyOwned)
+        {
+            httpParser->mBody.append(at, length);
+            httpParser->mBodyOwned = true;
+        }
+        else if (httpParser->mBodyView.empty())
+        {
+            httpParser->mBodyView = std::string_view(at, length);
+        }
+        else
+        {
+            // chunks are not contiguous
+            httpParser->ownBody();
+            httpParser->mBody.append(at, length);
+        }
         return 0;
     }
 
 private:
     const http_parser_type mParserType;
+    const bool mZeroCopy;
     http_parser mParser;
     http_parser_settings mSettings;
 
@@ -314,12 +596,30 @@ private:
     std::string mUrl;
     std::string mBody;
 
+    bool mHeadersCompleted = false;
+    bool mSkipBody = false;
+    // the body is in mBody rather than mBodyView
+    bool mBodyOwned = false;
+    std::string_view mUrlView;
+    std::string_view mPathView;
+    std::string_view mQueryView;
+    std::string_view mStatusView;
+    std::string_view mBodyView;
+    std::string_view mCurrentFieldView;
+    HttpHeaders mHeaders;
+    // the split message in zero copy mode
+    std::string mPending;
+
+    HeadersCallback mHeadersCallback;
+    BodyChunkCallback mBodyChunkCallback;
+
     std::string mWSCacheFrame;
     std::string mWSParsePayload;
     WebSocketFormat::WebSocketFrameType mWSFrameType;
 
 private:
     friend class HttpService;
+    friend class HttpClient;
 };
 
 }// namespace bsio::net::http
@@ -0,0 +1,406 @@
+#pragma once
+
+#include <array>
+#include <asio.hpp>
+#include <bsio/net/SendableMsg.hpp>
+#include <bsio/net/http/HttpStatus.hpp>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace bsio::net::http {
+
+namespace internal {
+
+// blocks and buffers freed by a thread are reused by the thread, each list is bounded.
+// the send of a response usually completes in the thread writing it.
+class OutputBufferPool : private asio::noncopyable
+{
+public:
+    static constexpr size_t BufferCapacity = 1024;
+    static constexpr size_t MaxBufferCapacity = 64 * 1024;
+    static constexpr size_t BlockSize = 128;
+    static constexpr size_t MaxFreeNum = 64;
+
+    // nullptr when the thread is exiting.
+    static OutputBufferPool* Local()
+    {
+        thread_local bool destroyed = false;
+        thread_local struct Holder {
+            OutputBufferPool pool;
+            ~Holder()
+            {
+                destroyed = true;
+            }
+        } holder;
+        return destroyed ? nullptr : &holder.pool;
+    }
+
+    std::string acquireBuffer()
+    {
+        if (mBuffers.empty())
+        {
+            std::string buffer;
+            buffer.reserve(BufferCapacity);
+            return buffer;
+        }
+        auto buffer = std::move(mBuffers.back());
+        mBuffers.pop_back();
+        return buffer;
+    }
+
+    void releaseBuffer(std::string&& buffer)
+    {
+        if (mBuffers.size() < MaxFreeNum && buffer.capacity() <= MaxBufferCapacity)
+        {
+            buffer.clear();
+            mBuffers.push_back(std::move(buffer));
+        }
+    }
+
+    void* allocateBlock()
+    {
+        if (mBlocks.empty())
+        {
+            return ::operator new(BlockSize);
+        }
+        const auto block = mBlocks.back();
+        mBlocks.pop_back();
+        return block;
+    }
+
+    void deallocateBlock(void* block)
+    {
+        if (mBlocks.size() < MaxFreeNum)
+        {
+            mBlocks.push_back(block);
+        }
+        else
+        {
+            ::operator delete(block);
+        }
+    }
+
+    ~OutputBufferPool()
+    {
+        for (const auto block : mBlocks)
+        {
+            ::operator delete(block);
+        }
+    }
+
+private:
+    std::vector<std::string> mBuffers;
+    std::vector<void*> mBlocks;
+};
+
+// allocates the control block and message of allocate_shared from the pool.
+template<typename T>
+class OutputBlockAllocator
+{
+public:
+    using value_type = T;
+
+    OutputBlockAllocator() = default;
+
+    template<typename U>
+    OutputBlockAllocator(const OutputBlockAllocator<U>&) noexcept
+    {
+    }
+
+    bool operator==(const OutputBlockAllocator&) const noexcept
+    {
+        return true;
+    }
+
+    bool operator!=(const OutputBlockAllocator&) const noexcept
+    {
+        return false;
+    }
+
+    T* allocate(size_t n) const
+    {
+        const auto size = sizeof(T) * n;
+        if (const auto pool = OutputBufferPool::Local(); pool != nullptr && size <= OutputBufferPool::BlockSize)
+        {
+            return static_cast<T*>(pool->allocateBlock());
+        }
+        return static_cast<T*>(::operator new(size <= OutputBufferPool::BlockSize ? OutputBufferPool::BlockSize : size));
+    }
+
+    void deallocate(T* p, size_t n) const
+    {
+        if (const auto pool = OutputBufferPool::Local(); pool != nullptr && sizeof(T) * n <= OutputBufferPool::BlockSize)
+        {
+            pool->deallocateBlock(p);
+            return;
+        }
+        ::operator delete(p);
+    }
+};
+
+// the buffer goes back to the pool when the message is sent.
+class PooledStringMsg : public SendableMsg
+{
+public:
+    explicit PooledStringMsg(std::string&& buffer)
+        : mMsg(std::move(buffer))
+    {
+    }
+
+    ~PooledStringMsg() override
+    {
+        if (const auto pool = OutputBufferPool::Local())
+        {
+            pool->releaseBuffer(std::move(mMsg));
+        }
+    }
+
+    const void* data() override
+    {
+        return static_cast<const void*>(mMsg.data());
+    }
+
+    size_t size() override
+    {
+        return mMsg.size();
+    }
+
+private:
+    std::string mMsg;
+};
+
+inline constexpr std::string_view HttpDays[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+inline constexpr std::string_view HttpMonths[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                                  "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+constexpr size_t HttpDateLength = sizeof("Sun, 06 Nov 1994 08:49:37 GMT") - 1;
+
+// larger than needed, so the compiler can see it's never truncated
+using HttpDateBuffer = char[64];
+
+inline std::string_view WriteHttpDate(std::time_t time, HttpDateBuffer& buffer)
+{
+    std::tm tm{};
+#ifdef _WIN32
+    gmtime_s(&tm, &time);
+#else
+    gmtime_r(&time, &tm);
+#endif
+    // locale independent
+    std::snprintf(buffer, sizeof(buffer), "%s, %02d %s %04d %02d:%02d:%02d GMT",
+                  HttpDays[tm.tm_wday].data(),
+                  tm.tm_mday,
+                  HttpMonths[tm.tm_mon].data(),
+                  tm.tm_year + 1900,
+                  tm.tm_hour,
+                  tm.tm_min,
+                  tm.tm_sec);
+    return std::string_view(buffer, HttpDateLength);
+}
+
+}// namespace internal
+
+// the value of Date header in IMF-fixdate, formatted once per second in each thread.
+inline std::string_view HttpDate()
+{
+    thread_local std::time_t cachedSecond = -1;
+    thread_local internal::HttpDateBuffer cachedDate;
+
+    const auto now = std::time(nullptr);
+    if (now != cachedSecond)
+    {
+        internal::WriteHttpDate(now, cachedDate);
+        cachedSecond = now;
+    }
+    return std::string_view(cachedDate, internal::HttpDateLength);
+}
+
+inline std::string FormatHttpDate(std::time_t time)
+{
+    internal::HttpDateBuffer buffer;
+    return std::string(internal::WriteHttpDate(time, buffer));
+}
+
+// parses IMF-fixdate, the obsolete formats are not accepted.
+inline std::optional<std::time_t> ParseHttpDate(std::string_view date)
+{
+    if (date.size() != internal::HttpDateLength || date.substr(3, 2) != ", " || date.substr(25) != " GMT")
+    {
+        return std::nullopt;
+    }
+    const auto number = [date](size_t pos, size_t len, int& value) {
+        const auto result = std::from_chars(date.data() + pos, date.data() + pos + len, value);
+        return result.ec == std::errc() && result.ptr == date.data() + pos + len;
+    };
+    int day = 0, year = 0, hour = 0, minute = 0, second = 0;
+    if (!number(5, 2, day) || !number(12, 4, year) || !number(17, 2, hour) ||
+        !number(20, 2, minute) || !number(23, 2, second) ||
+        date[7] != ' ' || date[11] != ' ' || date[16] != ' ' || date[19] != ':' || date[22] != ':')
+    {
+        return std::nullopt;
+    }
+    const auto monthName = date.substr(8, 3);
+    int month = 0;
+    while (month < 12 && internal::HttpMonths[month] != monthName)
+    {
+        month++;
+    }
+    if (month == 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60)
+    {
+        return std::nullopt;
+    }
+
+    // days since epoch of the civil date
+    const int y = month < 2 ? year - 1 : year;
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const int yearOfEra = y - era * 400;
+    const int dayOfYear = (153 * (month < 2 ? month + 10 : month - 2) + 2) / 5 + day - 1;
+    const int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    const auto days = static_cast<std::time_t>(era) * 146097 + dayOfEra - 719468;
+    return days * 86400 + hour * 3600 + minute * 60 + second;
+}
+
+// serializes the status line and headers of a response into a pooled buffer,
+// the body is sent as a separate buffer of the same write, so it's never copied.
+class HttpResponseWriter
+{
+public:
+    explicit HttpResponseWriter(int status = 200)
+        : mStatus(status)
+    {
+        if (const auto pool = internal::OutputBufferPool::Local())
+        {
+            mHead = pool->acquireBuffer();
+        }
+
+        char code[4] = {'0', '0', '0', ' '};
+        if (status >= internal::MinStatusCode && status <= internal::MaxStatusCode)
+        {
+            code[0] = static_cast<char>('0' + status / 100);
+            code[1] = static_cast<char>('0' + status / 10 % 10);
+            code[2] = static_cast<char>('0' + status % 10);
+        }
+        append({"HTTP/1.1 ",
+                std::string_view(code, sizeof(code)),
+                HttpStatusReason(status),
+                "\r\nDate: ",
+                HttpDate(),
+                "\r\n"});
+    }
+
+    HttpResponseWriter(HttpResponseWriter&&) = default;
+    HttpResponseWriter& operator=(HttpResponseWriter&&) = default;
+
+    ~HttpResponseWriter()
+    {
+        if (const auto pool = internal::OutputBufferPool::Local(); pool != nullptr && mHead.capacity() > 0)
+        {
+            pool->releaseBuffer(std::move(mHead));
+        }
+    }
+
+    // Date and Content-Length are written by the writer.
+    HttpResponseWriter& addHeader(std::string_view name, std::string_view value)
+    {
+        append({name, ": ", value, "\r\n"});
+        return *this;
+    }
+
+    HttpResponseWriter& setContentType(std::string_view value)
+    {
+        return addHeader("Content-Type", value);
+    }
+
+    HttpResponseWriter& setBody(std::string body)
+    {
+        mBody = MakeStringMsg(std::move(body));
+        return *this;
+    }
+
+    // the message can be shared by responses, such as a cached file.
+    HttpResponseWriter& setBody(SendableMsg::Ptr body)
+    {
+        mBody = std::move(body);
+        return *this;
+    }
+
+    // the body is sent after the head in chunked transfer-encoding, see HttpResponseStream.
+    HttpResponseWriter& setChunked()
+    {
+        mChunked = true;
+        return *this;
+    }
+
+    // the length of a body not sent with the response, such as the response of HEAD.
+    HttpResponseWriter& setContentLength(size_t length)
+    {
+        mContentLength = length;
+        return *this;
+    }
+
+    // the head and the body to send, body is nullptr if it's empty.
+    // the writer can't be used after.
+    std::pair<SendableMsg::Ptr, SendableMsg::Ptr> finish()
+    {
+        const auto bodySize = mBody != nullptr && !mChunked ? mBody->size() : 0;
+        const auto contentLength = mContentLength.value_or(bodySize);
+        if (mChunked)
+        {
+            append({"Transfer-Encoding: chunked\r\n"});
+        }
+        // 1xx and 204 must not have Content-Length, 304 has the length of the full response
+        else if ((mStatus >= 200 && mStatus != 204 && mStatus != 304) || contentLength > 0)
+        {
+            char length[20];
+            const auto result = std::to_chars(std::begin(length), std::end(length), contentLength);
+            append({"Content-Length: ",
+                    std::string_view(length, result.ptr - length),
+                    "\r\n"});
+        }
+        append({"\r\n"});
+
+        auto head = std::allocate_shared<internal::PooledStringMsg>(internal::OutputBlockAllocator<internal::PooledStringMsg>(),
+                                                                    std::move(mHead));
+        mHead = std::string();
+        if (bodySize == 0)
+        {
+            mBody = nullptr;
+        }
+        return {std::move(head), std::move(mBody)};
+    }
+
+private:
+    // one resize for all pieces.
+    void append(std::initializer_list<std::string_view> pieces)
+    {
+        size_t len = 0;
+        for (const auto& piece : pieces)
+        {
+            len += piece.size();
+        }
+        auto pos = mHead.size();
+        mHead.resize(pos + len);
+        for (const auto& piece : pieces)
+        {
+            std::memcpy(&mHead[pos], piece.data(), piece.size());
+            pos += piece.size();
+        }
+    }
+
+private:
+    int mStatus;
+    std::string mHead;
+    SendableMsg::Ptr mBody;
+    std::optional<size_t> mContentLength;
+    bool mChunked = false;
+};
+
+}// namespace bsio::net::http
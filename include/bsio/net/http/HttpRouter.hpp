@@ -0,0 +1,519 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bsio/net/http/HttpResponseWriter.hpp>
+#include <bsio/net/http/HttpService.hpp>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bsio::net::http {
+
+// the :params and *wildcard of a matched route, views of the path and of the router.
+class RouteParams
+{
+public:
+    static constexpr size_t MaxParamNum = 8;
+
+    struct Param {
+        std::string_view name;
+        std::string_view value;
+    };
+
+    // the value of param, or an empty view.
+    std::string_view get(std::string_view name) const noexcept
+    {
+        for (size_t i = 0; i < mSize; i++)
+        {
+            if (mParams[i].name == name)
+            {
+                return mParams[i].value;
+            }
+        }
+        return std::string_view();
+    }
+
+    size_t size() const noexcept
+    {
+        return mSize;
+    }
+
+    const Param& operator[](size_t index) const noexcept
+    {
+        return mParams[index];
+    }
+
+    void clear() noexcept
+    {
+        mSize = 0;
+    }
+
+private:
+    void push(std::string_view name, std::string_view value) noexcept
+    {
+        mParams[mSize++] = Param{name, value};
+    }
+
+    void pop() noexcept
+    {
+        mSize--;
+    }
+
+private:
+    std::array<Param, MaxParamNum> mParams;
+    size_t mSize = 0;
+
+    friend class HttpRouter;
+};
+
+// routes requests by method and path with a compressed radix tree of each method.
+// a pattern is made of static text, :name matching one non-empty segment, and *name at
+// the end matching the rest of path. static children are tried first, then param, then
+// wildcard, such as "/users/new" before "/users/:id" before "/users/*path".
+// routes are added before the router is used by sessions, freeze() then copies the trees
+// into flat arrays, matching doesn't allocate in both forms.
+class HttpRouter : private asio::noncopyable
+{
+public:
+    using Ptr = std::shared_ptr<HttpRouter>;
+    using Handler = std::function<void(const HTTPParser&, const HttpSession::Ptr&, const RouteParams&)>;
+
+    static constexpr size_t MethodNum = 64;
+
+    static Ptr Make()
+    {
+        class make_shared_enabler : public HttpRouter
+        {
+        };
+
+        return std::make_shared<make_shared_enabler>();
+    }
+
+    virtual ~HttpRouter() = default;
+
+    HttpRouter& add(http_method method, std::string_view pattern, Handler handler)
+    {
+        if (mFrozen)
+        {
+            throw std::runtime_error("router is frozen");
+        }
+        if (static_cast<size_t>(method) >= MethodNum)
+        {
+            throw std::runtime_error("unsupported method");
+        }
+        if (pattern.empty() || pattern.front() != '/')
+        {
+            throw std::runtime_error("pattern must start with /");
+        }
+
+        auto& root = mRoots[method];
+        if (root < 0)
+        {
+            root = newNode();
+        }
+        auto node = static_cast<uint32_t>(root);
+        size_t paramNum = 0;
+        while (!pattern.empty())
+        {
+            const auto special = pattern.find_first_of(":*");
+            node = insertStatic(node, pattern.substr(0, special));
+            if (special == std::string_view::npos)
+            {
+                break;
+            }
+            pattern.remove_prefix(special);
+
+            const auto isWildcard = pattern.front() == '*';
+            const auto end = isWildcard ? pattern.size() : pattern.find('/');
+            const auto name = pattern.substr(1, end == std::string_view::npos ? std::string_view::npos : end - 1);
+            // a wildcard runs to the end of pattern, so it must be the last segment
+            if (name.empty() || name.find_first_of("/:*") != std::string_view::npos)
+            {
+                throw std::runtime_error("invalid param name in pattern");
+            }
+            if (++paramNum > RouteParams::MaxParamNum)
+            {
+                throw std::runtime_error("too many params in pattern");
+            }
+            node = insertParam(node, name, isWildcard);
+            pattern.remove_prefix(end == std::string_view::npos ? pattern.size() : end);
+        }
+
+        if (mNodes[node].handler >= 0)
+        {
+            throw std::runtime_error("route already exists");
+        }
+        mNodes[node].handler = static_cast<int32_t>(mHandlers.size());
+        mHandlers.push_back(std::move(handler));
+        return *this;
+    }
+
+    HttpRouter& get(std::string_view pattern, Handler handler)
+    {
+        return add(HTTP_GET, pattern, std::move(handler));
+    }
+
+    HttpRouter& post(std::string_view pattern, Handler handler)
+    {
+        return add(HTTP_POST, pattern, std::move(handler));
+    }
+
+    HttpRouter& put(std::string_view pattern, Handler handler)
+    {
+        return add(HTTP_PUT, pattern, std::move(handler));
+    }
+
+    HttpRouter& del(std::string_view pattern, Handler handler)
+    {
+        return add(HTTP_DELETE, pattern, std::move(handler));
+    }
+
+    // called for requests matching no route, responds 404 by default.
+    HttpRouter& setNotFoundHandler(HttpSession::HttpParserCallback handler)
+    {
+        mNotFoundHandler = std::move(handler);
+        return *this;
+    }
+
+    // no route can be added after.
+    void freeze()
+    {
+        if (mFrozen)
+        {
+            return;
+        }
+
+        mFrozenNodes.resize(mNodes.size());
+        for (size_t i = 0; i < mNodes.size(); i++)
+        {
+            const auto& node = mNodes[i];
+            auto& frozen = mFrozenNodes[i];
+            frozen.prefix = appendChars(node.prefix);
+            frozen.name = appendChars(node.name);
+            frozen.firstChild = static_cast<uint32_t>(mChildIndexes.size());
+            frozen.childNum = static_cast<uint32_t>(node.children.size());
+            for (const auto child : node.children)
+            {
+                mChildIndexes.push_back(child);
+                mChildChars.push_back(mNodes[child].prefix.front());
+            }
+            frozen.param = node.param;
+            frozen.wildcard = node.wildcard;
+            frozen.handler = node.handler;
+        }
+        // names and prefixes are views of mChars
+        mChars.shrink_to_fit();
+        mChildIndexes.shrink_to_fit();
+        mChildChars.shrink_to_fit();
+        mNodes.clear();
+        mNodes.shrink_to_fit();
+        mFrozen = true;
+    }
+
+    bool frozen() const
+    {
+        return mFrozen;
+    }
+
+    // the handler of route matching method and path, or nullptr.
+    const Handler* match(int method, std::string_view path, RouteParams& params) const
+    {
+        params.clear();
+        if (method < 0 || static_cast<size_t>(method) >= MethodNum || mRoots[method] < 0)
+        {
+            return nullptr;
+        }
+
+        int32_t handler = -1;
+        const auto root = static_cast<uint32_t>(mRoots[method]);
+        const auto found = mFrozen ? matchNode(FrozenView{*this}, root, path, params, handler)
+                                   : matchNode(BuildView{*this}, root, path, params, handler);
+        return found ? &mHandlers[handler] : nullptr;
+    }
+
+    // call the handler of route matching the request.
+    void dispatch(const HTTPParser& parser, const HttpSession::Ptr& session) const
+    {
+        RouteParams params;
+        const auto handler = match(parser.method(), parser.path(), params);
+        if (handler != nullptr)
+        {
+            (*handler)(parser, session, params);
+        }
+        else if (mNotFoundHandler != nullptr)
+        {
+            mNotFoundHandler(parser, session);
+        }
+        else
+        {
+            session->sendResponse(HttpResponseWriter(404));
+        }
+    }
+
+protected:
+    HttpRouter()
+    {
+        mRoots.fill(-1);
+    }
+
+private:
+    struct Node {
+        std::string prefix;
+        // name of param or wildcard node
+        std::string name;
+        // static children, their prefixes start with different chars
+        std::vector<uint32_t> children;
+        int32_t param = -1;
+        int32_t wildcard = -1;
+        int32_t handler = -1;
+    };
+
+    struct Chars {
+        uint32_t offset = 0;
+        uint32_t size = 0;
+    };
+
+    struct FrozenNode {
+        Chars prefix;
+        Chars name;
+        uint32_t firstChild = 0;
+        uint32_t childNum = 0;
+        int32_t param = -1;
+        int32_t wildcard = -1;
+        int32_t handler = -1;
+    };
+
+    // the same matching runs on both forms of tree.
+
+    struct BuildView {
+        const HttpRouter& router;
+
+        std::string_view prefix(uint32_t node) const
+        {
+            return router.mNodes[node].prefix;
+        }
+
+        std::string_view name(uint32_t node) const
+        {
+            return router.mNodes[node].name;
+        }
+
+        int32_t child(uint32_t node, char c) const
+        {
+            for (const auto child : router.mNodes[node].children)
+            {
+                if (router.mNodes[child].prefix.front() == c)
+                {
+                    return static_cast<int32_t>(child);
+                }
+            }
+            return -1;
+        }
+
+        int32_t param(uint32_t node) const
+        {
+            return router.mNodes[node].param;
+        }
+
+        int32_t wildcard(uint32_t node) const
+        {
+            return router.mNodes[node].wildcard;
+        }
+
+        int32_t handler(uint32_t node) const
+        {
+            return router.mNodes[node].handler;
+        }
+    };
+
+    struct FrozenView {
+        const HttpRouter& router;
+
+        std::string_view chars(Chars chars) const
+        {
+            return std::string_view(router.mChars.data() + chars.offset, chars.size);
+        }
+
+        std::string_view prefix(uint32_t node) const
+        {
+            return chars(router.mFrozenNodes[node].prefix);
+        }
+
+        std::string_view name(uint32_t node) const
+        {
+            return chars(router.mFrozenNodes[node].name);
+        }
+
+        int32_t child(uint32_t node, char c) const
+        {
+            const auto& frozen = router.mFrozenNodes[node];
+            const auto first = router.mChildChars.data() + frozen.firstChild;
+            for (uint32_t i = 0; i < frozen.childNum; i++)
+            {
+                if (first[i] == c)
+                {
+                    return static_cast<int32_t>(router.mChildIndexes[frozen.firstChild + i]);
+                }
+            }
+            return -1;
+        }
+
+        int32_t param(uint32_t node) const
+        {
+            return router.mFrozenNodes[node].param;
+        }
+
+        int32_t wildcard(uint32_t node) const
+        {
+            return router.mFrozenNodes[node].wildcard;
+        }
+
+        int32_t handler(uint32_t node) const
+        {
+            return router.mFrozenNodes[node].handler;
+        }
+    };
+
+    template<typename View>
+    static bool matchNode(const View& view, uint32_t node, std::string_view path, RouteParams& params, int32_t& handler)
+    {
+        const auto prefix = view.prefix(node);
+        if (path.size() < prefix.size() || std::memcmp(path.data(), prefix.data(), prefix.size()) != 0)
+        {
+            return false;
+        }
+        path.remove_prefix(prefix.size());
+
+        if (path.empty() && view.handler(node) >= 0)
+        {
+            handler = view.handler(node);
+            return true;
+        }
+        if (!path.empty())
+        {
+            if (const auto child = view.child(node, path.front());
+                child >= 0 && matchNode(view, static_cast<uint32_t>(child), path, params, handler))
+            {
+                return true;
+            }
+        }
+        if (const auto param = view.param(node); param >= 0 && !path.empty() && path.front() != '/')
+        {
+            const auto end = std::min(path.find('/'), path.size());
+            params.push(view.name(static_cast<uint32_t>(param)), path.substr(0, end));
+            if (matchNode(view, static_cast<uint32_t>(param), path.substr(end), params, handler))
+            {
+                return true;
+            }
+            params.pop();
+        }
+        if (const auto wildcard = view.wildcard(node); wildcard >= 0)
+        {
+            params.push(view.name(static_cast<uint32_t>(wildcard)), path);
+            handler = view.handler(static_cast<uint32_t>(wildcard));
+            return true;
+        }
+        return false;
+    }
+
+    uint32_t newNode()
+    {
+        mNodes.emplace_back();
+        return static_cast<uint32_t>(mNodes.size() - 1);
+    }
+
+    // the node where text ends, nodes are split at the first different char.
+    uint32_t insertStatic(uint32_t node, std::string_view text)
+    {
+        while (!text.empty())
+        {
+            int32_t found = -1;
+            for (const auto child : mNodes[node].children)
+            {
+                if (mNodes[child].prefix.front() == text.front())
+                {
+                    found = static_cast<int32_t>(child);
+                    break;
+                }
+            }
+            if (found < 0)
+            {
+                const auto child = newNode();
+                mNodes[child].prefix = std::string(text);
+                mNodes[node].children.push_back(child);
+                return child;
+            }
+
+            auto child = static_cast<uint32_t>(found);
+            const auto& prefix = mNodes[child].prefix;
+            size_t common = 0;
+            while (common < prefix.size() && common < text.size() && prefix[common] == text[common])
+            {
+                common++;
+            }
+            if (common < prefix.size())
+            {
+                const auto middle = newNode();
+                mNodes[middle].prefix = mNodes[child].prefix.substr(0, common);
+                mNodes[middle].children.push_back(child);
+                mNodes[child].prefix.erase(0, common);
+                for (auto& index : mNodes[node].children)
+                {
+                    if (index == child)
+                    {
+                        index = middle;
+                    }
+                }
+                child = middle;
+            }
+            node = child;
+            text.remove_prefix(common);
+        }
+        return node;
+    }
+
+    uint32_t insertParam(uint32_t node, std::string_view name, bool isWildcard)
+    {
+        auto index = isWildcard ? mNodes[node].wildcard : mNodes[node].param;
+        if (index < 0)
+        {
+            index = static_cast<int32_t>(newNode());
+            mNodes[index].name = std::string(name);
+            (isWildcard ? mNodes[node].wildcard : mNodes[node].param) = index;
+        }
+        else if (mNodes[index].name != name)
+        {
+            throw std::runtime_error("conflict param name at same position");
+        }
+        return static_cast<uint32_t>(index);
+    }
+
+    Chars appendChars(const std::string& text)
+    {
+        Chars chars{static_cast<uint32_t>(mChars.size()), static_cast<uint32_t>(text.size())};
+        mChars += text;
+        return chars;
+    }
+
+private:
+    std::array<int32_t, MethodNum> mRoots;
+    std::vector<Handler> mHandlers;
+    HttpSession::HttpParserCallback mNotFoundHandler;
+
+    std::vector<Node> mNodes;
+
+    bool mFrozen = false;
+    std::vector<FrozenNode> mFrozenNodes;
+    // first char of prefix of each child, scanned before loading the child
+    std::vector<char> mChildChars;
+    std::vector<uint32_t> mChildIndexes;
+    std::string mChars;
+};
+
+}// namespace bsio::net::http
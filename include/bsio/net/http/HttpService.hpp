@@ -1,18 +1,28 @@
 ﻿#pragma once
 
 #include <asio.hpp>
+#include <atomic>
+#include <bsio/net/SendableMsg.hpp>
 #include <bsio/net/TcpSession.hpp>
 #include <bsio/net/http/HttpParser.hpp>
+#include <bsio/net/http/HttpResponseWriter.hpp>
 #include <bsio/net/http/WebSocketFormat.hpp>
+#include <charconv>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <string_view>
 #include <thread>
 #include <utility>
+#include <vector>
 
 namespace bsio::net::http {
 
 class HttpService;
+class HttpResponseStream;
 
-class HttpSession : private asio::noncopyable
+class HttpSession : public std::enable_shared_from_this<HttpSession>,
+                    private asio::noncopyable
 {
 public:
     using Ptr = std::shared_ptr<HttpSession>;
@@ -24,7 +34,13 @@ public:
                                           const std::string& payload)>;
 
     using ClosedCallback = std::function<void(const HttpSession::Ptr&)>;
+    // requests of one connection are numbered from 0 in the order they are parsed.
+    using RequestSeq = uint64_t;
     using WsConnectedCallback = std::function<void(const HttpSession::Ptr&, const HTTPParser&)>;
+    // the body is passed to BodyChunkCallback as it arrives instead of being accumulated,
+    // HttpParserCallback is still called when the message completes, with an empty body.
+    using HeadersCallback = std::function<void(const HTTPParser&, const HttpSession::Ptr&)>;
+    using BodyChunkCallback = std::function<void(const HTTPParser&, const HttpSession::Ptr&, std::string_view chunk)>;
 
 public:
     HttpSession(
@@ -51,11 +67,78 @@ public:
     void send(const char* packet, size_t len, TcpSession::SendCompletedCallback&& callback = nullptr) const
     {
         mSession->send(std::string(packet, len), std::forward<TcpSession::SendCompletedCallback>(callback));
+        markUnorderedSend();
     }
 
     void send(std::string packet, TcpSession::SendCompletedCallback&& callback = nullptr) const
     {
         mSession->send(std::move(packet), std::forward<TcpSession::SendCompletedCallback>(callback));
+        markUnorderedSend();
+    }
+
+    // the sequence of request whose HttpParserCallback is running, keep it to respond later.
+    RequestSeq currentRequest() const
+    {
+        return mCurrentRequest;
+    }
+
+    // responses of pipelined requests go out in the order of requests, a response completed
+    // before the responses of previous requests is held until they are sent.
+    // every request must be responded once when this is used, and send() must not be mixed in.
+    void sendResponse(RequestSeq seq, std::string response, TcpSession::SendCompletedCallback callback = nullptr)
+    {
+        sendResponse(seq, PendingResponse{MakeStringMsg(std::move(response)), nullptr, std::move(callback), nullptr});
+    }
+
+    // the head and body of writer are sent as two segments of one message.
+    void sendResponse(RequestSeq seq, HttpResponseWriter&& writer, TcpSession::SendCompletedCallback callback = nullptr)
+    {
+        auto [head, body] = writer.finish();
+        sendResponse(seq, PendingResponse{std::move(head), std::move(body), std::move(callback), nullptr});
+    }
+
+    // respond to the request whose callback is running.
+    void sendResponse(std::string response, TcpSession::SendCompletedCallback callback = nullptr)
+    {
+        sendResponse(mCurrentRequest, std::move(response), std::move(callback));
+    }
+
+    void sendResponse(HttpResponseWriter&& writer, TcpSession::SendCompletedCallback callback = nullptr)
+    {
+        sendResponse(mCurrentRequest, std::move(writer), std::move(callback));
+    }
+
+    // the head of writer is sent with Transfer-Encoding: chunked, then the body is written
+    // by the stream chunk by chunk until finish(). the stream takes the turn of seq like
+    // sendResponse, chunks written before its turn are held, and the responses of later
+    // requests are held until it's finished.
+    std::shared_ptr<HttpResponseStream> startStreamResponse(RequestSeq seq, HttpResponseWriter&& writer);
+
+    std::shared_ptr<HttpResponseStream> startStreamResponse(HttpResponseWriter&& writer);
+
+    // stop reading from socket, such as when the consumer of body chunks is slow,
+    // the chunks after the current one are passed after resumeRecv.
+    void pauseRecv()
+    {
+        mRecvPaused.store(true, std::memory_order_relaxed);
+        mSession->pauseRecv();
+    }
+
+    void resumeRecv()
+    {
+        mRecvPaused.store(false, std::memory_order_relaxed);
+        mSession->resumeRecv();
+    }
+
+    bool recvPaused() const
+    {
+        return mRecvPaused.load(std::memory_order_relaxed);
+    }
+
+    void setStreamingCallback(HeadersCallback headersCallback, BodyChunkCallback bodyChunkCallback)
+    {
+        mHeadersCallback = std::move(headersCallback);
+        mBodyChunkCallback = std::move(bodyChunkCallback);
     }
 
     void shutdown(asio::ip::tcp::socket::shutdown_type type) const
@@ -75,6 +158,13 @@ public:
         return mSession;
     }
 
+    // the user data in the slot of tcp session.
+    template<typename T>
+    T* userData() const noexcept
+    {
+        return mSession->userData<T>();
+    }
+
     const HttpParserCallback& getHttpCallback() const
     {
         return mHttpRequestCallback;
@@ -95,6 +185,168 @@ public:
         return mWSConnectedCallback;
     }
 
+    const HeadersCallback& getHeadersCallback() const
+    {
+        return mHeadersCallback;
+    }
+
+    const BodyChunkCallback& getBodyChunkCallback() const
+    {
+        return mBodyChunkCallback;
+    }
+
+private:
+    // guarded by mResponseGuard.
+    struct StreamState {
+        // the head is sent, chunks are sent as they are written
+        bool active = false;
+        bool finished = false;
+        std::vector<std::pair<SendableMsg::Ptr, TcpSession::SendCompletedCallback>> held;
+    };
+
+    struct PendingResponse {
+        SendableMsg::Ptr head;
+        // nullptr if the response is one message
+        SendableMsg::Ptr body;
+        TcpSession::SendCompletedCallback callback;
+        // not nullptr if the body is written by HttpResponseStream
+        std::shared_ptr<StreamState> stream;
+    };
+
+    void sendResponse(RequestSeq seq, PendingResponse&& response)
+    {
+        std::lock_guard<std::mutex> lck(mResponseGuard);
+        if (seq != mNextResponse)
+        {
+            mPendingResponses.emplace(seq, std::move(response));
+            return;
+        }
+
+        doSendResponse(std::move(response));
+        sendPendingResponses();
+    }
+
+    // the held responses are sent until one is missing or a stream isn't finished.
+    void sendPendingResponses()
+    {
+        for (auto it = mPendingResponses.begin();
+             it != mPendingResponses.end() && it->first == mNextResponse;)
+        {
+            auto response = std::move(it->second);
+            it = mPendingResponses.erase(it);
+            doSendResponse(std::move(response));
+        }
+        tryCloseAfterResponses();
+    }
+
+    // return false if the stream is finished.
+    bool writeStream(StreamState& stream, SendableMsg::Ptr msg, TcpSession::SendCompletedCallback callback, bool last)
+    {
+        std::lock_guard<std::mutex> lck(mResponseGuard);
+        if (stream.finished)
+        {
+            return false;
+        }
+        stream.finished = last;
+        if (!stream.active)
+        {
+            stream.held.emplace_back(std::move(msg), std::move(callback));
+            return true;
+        }
+        mSession->send(std::move(msg), std::move(callback));
+        if (last)
+        {
+            mNextResponse++;
+            sendPendingResponses();
+        }
+        return true;
+    }
+
+    // the response can't be completed, so the connection is closed.
+    void abortStream(StreamState& stream)
+    {
+        {
+            std::lock_guard<std::mutex> lck(mResponseGuard);
+            if (stream.finished)
+            {
+                return;
+            }
+            stream.finished = true;
+        }
+        mSession->close();
+    }
+
+    // called in session's thread when peer closed its sending side, the session is closed
+    // after the responses of received requests are sent by sendResponse, or after the data
+    // queued by send() is sent if send() is used.
+    void closeAfterResponses()
+    {
+        std::lock_guard<std::mutex> lck(mResponseGuard);
+        mPeerClosed = true;
+        mLastRequest = mNextRequest;
+        tryCloseAfterResponses();
+    }
+
+    void markUnorderedSend() const
+    {
+        if (mUnorderedSend)
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> lck(mResponseGuard);
+        mUnorderedSend = true;
+        tryCloseAfterResponses();
+    }
+
+    void tryCloseAfterResponses() const
+    {
+        if (!mPeerClosed || (!mUnorderedSend && mNextResponse != mLastRequest))
+        {
+            return;
+        }
+        mPeerClosed = false;
+        // the empty message completes after everything queued before it
+        mSession->send(std::string(), [session = mSession]() {
+            session->close();
+        });
+    }
+
+    void doSendResponse(PendingResponse&& response)
+    {
+        if (response.stream != nullptr)
+        {
+            auto& stream = *response.stream;
+            mSession->send(std::move(response.head));
+            for (auto& [msg, callback] : stream.held)
+            {
+                mSession->send(std::move(msg), std::move(callback));
+            }
+            stream.held.clear();
+            stream.active = true;
+            if (stream.finished)
+            {
+                mNextResponse++;
+            }
+            return;
+        }
+        if (response.body == nullptr)
+        {
+            mSession->send(std::move(response.head), std::move(response.callback));
+        }
+        else
+        {
+            // one gather write, the body is never copied behind the head
+            mSession->send(MakeCompositeMsg({std::move(response.head), std::move(response.body)}),
+                           std::move(response.callback));
+        }
+        mNextResponse++;
+    }
+
+    void beginRequest()
+    {
+        mCurrentRequest = mNextRequest++;
+    }
+
 private:
     std::once_flag mOnce;
     TcpSession::Ptr mSession;
@@ -102,10 +354,143 @@ private:
     WsCallback mWSCallback;
     ClosedCallback mCloseCallback;
     WsConnectedCallback mWSConnectedCallback;
+    HeadersCallback mHeadersCallback;
+    BodyChunkCallback mBodyChunkCallback;
+    std::atomic<bool> mRecvPaused{false};
+
+    // accessed in session's thread
+    RequestSeq mNextRequest = 0;
+    RequestSeq mCurrentRequest = 0;
+
+    // send() is const
+    mutable std::mutex mResponseGuard;
+    RequestSeq mNextResponse = 0;
+    mutable std::atomic<bool> mUnorderedSend{false};
+    mutable bool mPeerClosed = false;
+    // the sequence after the last request received before peer closed
+    RequestSeq mLastRequest = 0;
+    std::map<RequestSeq, PendingResponse> mPendingResponses;
 
     friend class HttpService;
+    friend class HttpResponseStream;
+};
+
+namespace internal {
+
+// the size line of a chunk, it's small, so it's stored in the message.
+class ChunkSizeMsg : public SendableMsg
+{
+public:
+    explicit ChunkSizeMsg(size_t chunkSize)
+    {
+        const auto result = std::to_chars(std::begin(mLine), std::end(mLine) - 2, chunkSize, 16);
+        result.ptr[0] = '\r';
+        result.ptr[1] = '\n';
+        mSize = static_cast<size_t>(result.ptr + 2 - mLine);
+    }
+
+    const void* data() override
+    {
+        return mLine;
+    }
+
+    size_t size() override
+    {
+        return mSize;
+    }
+
+private:
+    char mLine[20];
+    size_t mSize;
 };
 
+}// namespace internal
+
+// writes the body of a response in chunked transfer-encoding, each chunk is sent as
+// a size line, the chunk and CRLF in one message, the chunk is never copied. it can
+// be used from any thread; a stream dropped before finish() closes the connection.
+class HttpResponseStream : private asio::noncopyable
+{
+public:
+    using Ptr = std::shared_ptr<HttpResponseStream>;
+
+    HttpResponseStream(HttpSession::Ptr session, std::shared_ptr<HttpSession::StreamState> state)
+        : mSession(std::move(session)),
+          mState(std::move(state))
+    {
+    }
+
+    virtual ~HttpResponseStream()
+    {
+        mSession->abortStream(*mState);
+    }
+
+    // return false if the stream is finished, empty chunks are skipped.
+    bool write(SendableMsg::Ptr chunk, TcpSession::SendCompletedCallback callback = nullptr)
+    {
+        const auto size = chunk->size();
+        if (size == 0 && callback == nullptr)
+        {
+            return !finished();
+        }
+        std::vector<SendableMsg::Ptr> segments;
+        if (size > 0)
+        {
+            segments.reserve(3);
+            segments.push_back(std::allocate_shared<internal::ChunkSizeMsg>(internal::OutputBlockAllocator<internal::ChunkSizeMsg>(), size));
+            segments.push_back(std::move(chunk));
+            segments.push_back(Crlf());
+        }
+        return mSession->writeStream(*mState,
+                                     std::allocate_shared<CompositeSendMsg>(internal::OutputBlockAllocator<CompositeSendMsg>(),
+                                                                            std::move(segments)),
+                                     std::move(callback),
+                                     false);
+    }
+
+    bool write(std::string chunk, TcpSession::SendCompletedCallback callback = nullptr)
+    {
+        return write(MakeStringMsg(std::move(chunk)), std::move(callback));
+    }
+
+    // sends the last chunk, the callback is called when the whole response is sent.
+    bool finish(TcpSession::SendCompletedCallback callback = nullptr)
+    {
+        static const auto LastChunk = MakeStringMsg(std::string("0\r\n\r\n"));
+        return mSession->writeStream(*mState, LastChunk, std::move(callback), true);
+    }
+
+    bool finished() const
+    {
+        std::lock_guard<std::mutex> lck(mSession->mResponseGuard);
+        return mState->finished;
+    }
+
+private:
+    static const SendableMsg::Ptr& Crlf()
+    {
+        static const auto crlf = MakeStringMsg(std::string("\r\n"));
+        return crlf;
+    }
+
+private:
+    const HttpSession::Ptr mSession;
+    const std::shared_ptr<HttpSession::StreamState> mState;
+};
+
+inline HttpResponseStream::Ptr HttpSession::startStreamResponse(RequestSeq seq, HttpResponseWriter&& writer)
+{
+    auto state = std::make_shared<StreamState>();
+    auto head = writer.setChunked().finish().first;
+    sendResponse(seq, PendingResponse{std::move(head), nullptr, nullptr, state});
+    return std::make_shared<HttpResponseStream>(shared_from_this(), std::move(state));
+}
+
+inline HttpResponseStream::Ptr HttpSession::startStreamResponse(HttpResponseWriter&& writer)
+{
+    return startStreamResponse(mCurrentRequest, std::move(writer));
+}
+
 class HttpService
 {
 public:
@@ -182,22 +567,18 @@ public:
                               const HTTPParser::Ptr& httpParser,
                               const HttpSession::Ptr& httpSession)
     {
-        size_t retlen = len;
+        // one message is parsed at most, the rest is parsed in the next call.
+        const auto retlen = httpParser->tryParse(buffer, len);
         if (!httpParser->isCompleted())
         {
-            retlen = httpParser->tryParse(buffer, len);
-            if (!httpParser->isCompleted())
-            {
-                return retlen;
-            }
+            return retlen;
         }
 
         if (httpParser->isWebSocket())
         {
-            if (httpParser->hasKey("Sec-WebSocket-Key"))
+            if (const auto secKey = httpParser->header(HttpField::SecWebSocketKey); !secKey.empty())
             {
-                auto response = WebSocketFormat::wsHandshake(
-                        httpParser->getValue("Sec-WebSocket-Key"));
+                auto response = WebSocketFormat::wsHandshake(std::string(secKey));
                 httpSession->send(response.c_str(),
                                   response.size());
             }
@@ -210,6 +591,7 @@ public:
         }
         else
         {
+            httpSession->beginRequest();
             const auto& httpCallback = httpSession->getHttpCallback();
             if (httpCallback != nullptr)
             {
@@ -219,6 +601,17 @@ public:
 
         return retlen;
     }
+
+    // pass EOF to parser, such as for a response delimited by closing connection.
+    static void ProcessEof(const HTTPParser::Ptr& httpParser,
+                           const HttpSession::Ptr& httpSession)
+    {
+        if (!httpParser->isCompleted())
+        {
+            ProcessHttp(nullptr, 0, httpParser, httpSession);
+        }
+        httpSession->closeAfterResponses();
+    }
 };
 
 }// namespace bsio::net::http
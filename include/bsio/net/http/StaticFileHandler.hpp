@@ -0,0 +1,652 @@
+#pragma once
+
+#include <algorithm>
+#include <asio.hpp>
+#include <bsio/net/SendableMsg.hpp>
+#include <bsio/net/http/HttpResponseWriter.hpp>
+#include <bsio/net/http/HttpRouter.hpp>
+#include <bsio/net/http/HttpService.hpp>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <fcntl.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sys/stat.h>
+#include <unordered_map>
+#include <utility>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace bsio::net::http {
+
+namespace internal {
+
+struct FileInfo {
+    uint64_t id = 0;
+    uint64_t size = 0;
+    std::time_t mtime = 0;
+};
+
+#ifdef _WIN32
+inline int OpenFile(const std::string& path)
+{
+    return ::_open(path.c_str(), _O_RDONLY | _O_BINARY | _O_NOINHERIT);
+}
+
+inline void CloseFile(int fd)
+{
+    ::_close(fd);
+}
+
+inline bool StatFile(const std::string& path, FileInfo& info)
+{
+    struct _stat64 st;
+    if (::_stat64(path.c_str(), &st) != 0 || (st.st_mode & _S_IFMT) != _S_IFREG)
+    {
+        return false;
+    }
+    info = FileInfo{static_cast<uint64_t>(st.st_ino), static_cast<uint64_t>(st.st_size), st.st_mtime};
+    return true;
+}
+
+inline bool StatFile(int fd, FileInfo& info)
+{
+    struct _stat64 st;
+    if (::_fstat64(fd, &st) != 0 || (st.st_mode & _S_IFMT) != _S_IFREG)
+    {
+        return false;
+    }
+    info = FileInfo{static_cast<uint64_t>(st.st_ino), static_cast<uint64_t>(st.st_size), st.st_mtime};
+    return true;
+}
+#else
+inline int OpenFile(const std::string& path)
+{
+    return ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+}
+
+inline void CloseFile(int fd)
+{
+    ::close(fd);
+}
+
+inline bool StatFile(const std::string& path, FileInfo& info)
+{
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        return false;
+    }
+    info = FileInfo{static_cast<uint64_t>(st.st_ino), static_cast<uint64_t>(st.st_size), st.st_mtime};
+    return true;
+}
+
+inline bool StatFile(int fd, FileInfo& info)
+{
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        return false;
+    }
+    info = FileInfo{static_cast<uint64_t>(st.st_ino), static_cast<uint64_t>(st.st_size), st.st_mtime};
+    return true;
+}
+#endif
+
+// an open file and the validators of its content, fd is -1 if the file doesn't exist.
+// the descriptor is closed when the cache and all messages sending it drop the file.
+struct CachedFile : private asio::noncopyable {
+    ~CachedFile()
+    {
+        if (fd >= 0)
+        {
+            CloseFile(fd);
+        }
+    }
+
+    std::string path;
+    int fd = -1;
+    FileInfo info;
+    std::string etag;
+    std::string lastModified;
+};
+
+inline bool EqualsIgnoreCase(std::string_view a, std::string_view b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+               return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+           });
+}
+
+inline std::string_view TrimSpace(std::string_view value)
+{
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+    {
+        value.remove_prefix(1);
+    }
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+    {
+        value.remove_suffix(1);
+    }
+    return value;
+}
+
+// calls func with each element of a comma separated list until it returns true.
+template<typename Func>
+bool AnyOfList(std::string_view list, Func&& func)
+{
+    while (!list.empty())
+    {
+        const auto comma = list.find(',');
+        if (const auto element = TrimSpace(list.substr(0, comma)); !element.empty() && func(element))
+        {
+            return true;
+        }
+        list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+    }
+    return false;
+}
+
+inline bool AcceptsGzip(std::string_view acceptEncoding)
+{
+    return AnyOfList(acceptEncoding, [](std::string_view coding) {
+        const auto semicolon = coding.find(';');
+        if (!EqualsIgnoreCase(TrimSpace(coding.substr(0, semicolon)), "gzip"))
+        {
+            return false;
+        }
+        if (semicolon == std::string_view::npos)
+        {
+            return true;
+        }
+        // q=0 means not acceptable
+        auto q = TrimSpace(coding.substr(semicolon + 1));
+        if (q.size() < 2 || (q[0] != 'q' && q[0] != 'Q') || q[1] != '=')
+        {
+            return true;
+        }
+        q.remove_prefix(2);
+        return q.find_first_not_of("0.") != std::string_view::npos;
+    });
+}
+
+// weak comparison of If-None-Match.
+inline bool MatchesETag(std::string_view ifNoneMatch, std::string_view etag)
+{
+    return AnyOfList(ifNoneMatch, [etag](std::string_view tag) {
+        if (tag == "*")
+        {
+            return true;
+        }
+        if (tag.substr(0, 2) == "W/")
+        {
+            tag.remove_prefix(2);
+        }
+        return tag == etag;
+    });
+}
+
+// a single byte range, [first, last] are inclusive.
+struct ByteRange {
+    uint64_t first = 0;
+    uint64_t last = 0;
+};
+
+enum class RangeResult
+{
+    // absent, malformed or multiple ranges, the full content is sent
+    Ignored,
+    Satisfiable,
+    Unsatisfiable,
+};
+
+inline RangeResult ParseRange(std::string_view range, uint64_t size, ByteRange& result)
+{
+    constexpr std::string_view Unit = "bytes=";
+    if (range.size() <= Unit.size() || !EqualsIgnoreCase(range.substr(0, Unit.size()), Unit))
+    {
+        return RangeResult::Ignored;
+    }
+    range = TrimSpace(range.substr(Unit.size()));
+    const auto dash = range.find('-');
+    if (dash == std::string_view::npos || range.find(',') != std::string_view::npos)
+    {
+        return RangeResult::Ignored;
+    }
+    const auto parse = [](std::string_view text, uint64_t& value) {
+        const auto end = text.data() + text.size();
+        const auto parsed = std::from_chars(text.data(), end, value);
+        return !text.empty() && parsed.ec == std::errc() && parsed.ptr == end;
+    };
+    const auto firstText = TrimSpace(range.substr(0, dash));
+    const auto lastText = TrimSpace(range.substr(dash + 1));
+    uint64_t first = 0;
+    uint64_t last = 0;
+    if (firstText.empty())
+    {
+        // the last n bytes
+        if (!parse(lastText, last))
+        {
+            return RangeResult::Ignored;
+        }
+        if (last == 0 || size == 0)
+        {
+            return RangeResult::Unsatisfiable;
+        }
+        result = ByteRange{size - std::min(last, size), size - 1};
+        return RangeResult::Satisfiable;
+    }
+    if (!parse(firstText, first) || (!lastText.empty() && (!parse(lastText, last) || last < first)))
+    {
+        return RangeResult::Ignored;
+    }
+    if (first >= size)
+    {
+        return RangeResult::Unsatisfiable;
+    }
+    result = ByteRange{first, lastText.empty() ? size - 1 : std::min(last, size - 1)};
+    return RangeResult::Satisfiable;
+}
+
+inline std::string_view ContentTypeOf(std::string_view path)
+{
+    static constexpr std::pair<std::string_view, std::string_view> Types[] = {
+            {"html", "text/html; charset=utf-8"},
+            {"htm", "text/html; charset=utf-8"},
+            {"css", "text/css; charset=utf-8"},
+            {"js", "text/javascript; charset=utf-8"},
+            {"mjs", "text/javascript; charset=utf-8"},
+            {"json", "application/json"},
+            {"txt", "text/plain; charset=utf-8"},
+            {"xml", "application/xml"},
+            {"svg", "image/svg+xml"},
+            {"png", "image/png"},
+            {"jpg", "image/jpeg"},
+            {"jpeg", "image/jpeg"},
+            {"gif", "image/gif"},
+            {"webp", "image/webp"},
+            {"ico", "image/x-icon"},
+            {"wasm", "application/wasm"},
+            {"woff", "font/woff"},
+            {"woff2", "font/woff2"},
+            {"pdf", "application/pdf"},
+            {"mp4", "video/mp4"},
+    };
+    const auto slash = path.rfind('/');
+    const auto dot = path.rfind('.');
+    if (dot != std::string_view::npos && (slash == std::string_view::npos || dot > slash))
+    {
+        const auto extension = path.substr(dot + 1);
+        for (const auto& [name, type] : Types)
+        {
+            if (EqualsIgnoreCase(extension, name))
+            {
+                return type;
+            }
+        }
+    }
+    return "application/octet-stream";
+}
+
+// decodes %XX and rejects the paths escaping root, empty if the path is invalid.
+inline std::string NormalizePath(std::string_view path)
+{
+    std::string decoded;
+    decoded.reserve(path.size());
+    for (size_t i = 0; i < path.size(); i++)
+    {
+        auto c = path[i];
+        if (c == '%')
+        {
+            unsigned int value = 0;
+            if (i + 2 >= path.size() ||
+                std::from_chars(path.data() + i + 1, path.data() + i + 3, value, 16).ptr != path.data() + i + 3)
+            {
+                return std::string();
+            }
+            c = static_cast<char>(value);
+            i += 2;
+        }
+        if (c == '\0' || c == '\\')
+        {
+            return std::string();
+        }
+        decoded.push_back(c);
+    }
+
+    std::string normalized;
+    normalized.reserve(decoded.size() + 1);
+    std::string_view rest = decoded;
+    while (!rest.empty())
+    {
+        const auto slash = rest.find('/');
+        const auto segment = rest.substr(0, slash);
+        if (segment == "..")
+        {
+            return std::string();
+        }
+        if (!segment.empty() && segment != ".")
+        {
+            normalized.push_back('/');
+            normalized.append(segment);
+        }
+        rest = slash == std::string_view::npos ? std::string_view() : rest.substr(slash + 1);
+    }
+    if (normalized.empty() || decoded.back() == '/')
+    {
+        normalized.append("/index.html");
+    }
+    return normalized;
+}
+
+}// namespace internal
+
+// serves files under root for GET and HEAD. open descriptors and stat results are kept
+// in a LRU cache and revalidated by stat after statInterval, missing paths are kept in a
+// smaller one, so they never evict open files. bodies are sent by sendfile
+// from the send queue of the session. answers If-None-Match and If-Modified-Since with
+// 304, a single Range with 206, and sends the sibling file.gz to clients accepting gzip.
+class StaticFileHandler : public std::enable_shared_from_this<StaticFileHandler>,
+                          private asio::noncopyable
+{
+public:
+    using Ptr = std::shared_ptr<StaticFileHandler>;
+
+    static Ptr Make(std::string root,
+                    size_t maxCachedFiles = 1024,
+                    std::chrono::milliseconds statInterval = std::chrono::seconds(1))
+    {
+        class make_shared_enabler : public StaticFileHandler
+        {
+        public:
+            make_shared_enabler(std::string root, size_t maxCachedFiles, std::chrono::milliseconds statInterval)
+                : StaticFileHandler(std::move(root), maxCachedFiles, statInterval)
+            {}
+        };
+
+        return std::make_shared<make_shared_enabler>(std::move(root), maxCachedFiles, statInterval);
+    }
+
+    virtual ~StaticFileHandler() = default;
+
+    // whether file.gz is looked up, on by default.
+    StaticFileHandler& setPrecompressed(bool precompressed)
+    {
+        mPrecompressed = precompressed;
+        return *this;
+    }
+
+    // routes GET and HEAD of prefix + "*path" to the handler, prefix ends with '/'.
+    void mount(HttpRouter& router, std::string_view prefix)
+    {
+        const auto pattern = std::string(prefix) + "*path";
+        const auto handler = [self = shared_from_this()](const HTTPParser& parser,
+                                                         const HttpSession::Ptr& session,
+                                                         const RouteParams& params) {
+            self->serve(parser, session, params.get("path"));
+        };
+        router.add(HTTP_GET, pattern, handler);
+        router.add(HTTP_HEAD, pattern, handler);
+    }
+
+    // path is relative to root, percent-encoded.
+    void serve(const HTTPParser& parser, const HttpSession::Ptr& session, std::string_view path) const
+    {
+        const auto method = parser.method();
+        if (method != HTTP_GET && method != HTTP_HEAD)
+        {
+            HttpResponseWriter writer(405);
+            writer.addHeader("Allow", "GET, HEAD");
+            session->sendResponse(std::move(writer));
+            return;
+        }
+        const auto normalized = internal::NormalizePath(path);
+        if (normalized.empty())
+        {
+            session->sendResponse(HttpResponseWriter(404));
+            return;
+        }
+
+        const auto original = lookup(mRoot + normalized, false);
+        std::shared_ptr<const internal::CachedFile> compressed;
+        if (mPrecompressed && original->fd >= 0)
+        {
+            compressed = lookup(original->path + ".gz", true);
+        }
+        const auto hasCompressed = compressed != nullptr && compressed->fd >= 0;
+        const auto useCompressed = hasCompressed && internal::AcceptsGzip(parser.header(HttpField::AcceptEncoding));
+        if (!useCompressed && original->fd < 0)
+        {
+            session->sendResponse(HttpResponseWriter(404));
+            return;
+        }
+        const auto& file = useCompressed ? compressed : original;
+
+        if (notModified(parser, *file))
+        {
+            HttpResponseWriter writer(304);
+            writeValidators(writer, *file, hasCompressed);
+            session->sendResponse(std::move(writer));
+            return;
+        }
+
+        const auto size = file->info.size;
+        internal::ByteRange range{0, size > 0 ? size - 1 : 0};
+        auto result = internal::RangeResult::Ignored;
+        if (const auto rangeHeader = parser.header(HttpField::Range); !rangeHeader.empty() && rangeMatches(parser, *file))
+        {
+            result = internal::ParseRange(rangeHeader, size, range);
+        }
+        if (result == internal::RangeResult::Unsatisfiable)
+        {
+            HttpResponseWriter writer(416);
+            writer.addHeader("Content-Range", "bytes */" + std::to_string(size));
+            session->sendResponse(std::move(writer));
+            return;
+        }
+
+        HttpResponseWriter writer(result == internal::RangeResult::Satisfiable ? 206 : 200);
+        writer.setContentType(internal::ContentTypeOf(original->path));
+        writeValidators(writer, *file, hasCompressed);
+        writer.addHeader("Accept-Ranges", "bytes");
+        if (useCompressed)
+        {
+            writer.addHeader("Content-Encoding", "gzip");
+        }
+        if (result == internal::RangeResult::Satisfiable)
+        {
+            writer.addHeader("Content-Range",
+                             "bytes " + std::to_string(range.first) + "-" + std::to_string(range.last) + "/" + std::to_string(size));
+        }
+        const auto length = size > 0 ? range.last - range.first + 1 : 0;
+        if (method == HTTP_HEAD)
+        {
+            writer.setContentLength(static_cast<size_t>(length));
+        }
+        else if (length > 0)
+        {
+            writer.setBody(MakeFileMsg(file, FileRange{file->fd, range.first, static_cast<size_t>(length)}));
+        }
+        session->sendResponse(std::move(writer));
+    }
+
+protected:
+    StaticFileHandler(std::string root, size_t maxCachedFiles, std::chrono::milliseconds statInterval)
+        : mRoot(std::move(root)),
+          mStatInterval(statInterval)
+    {
+        while (!mRoot.empty() && mRoot.back() == '/')
+        {
+            mRoot.pop_back();
+        }
+        mOpenFiles.capacity = std::max<size_t>(maxCachedFiles, 1);
+        mMissingFiles.capacity = std::max<size_t>(maxCachedFiles / 4, 1);
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct CacheSlot {
+        std::shared_ptr<const internal::CachedFile> file;
+        Clock::time_point checkedAt;
+    };
+
+    // most recently used first
+    struct CacheList {
+        std::list<CacheSlot> slots;
+        // keys are views of the path of files in slots
+        std::unordered_map<std::string_view, std::list<CacheSlot>::iterator> index;
+        size_t capacity = 0;
+
+        CacheSlot* find(const std::string& path)
+        {
+            const auto it = index.find(path);
+            if (it == index.end())
+            {
+                return nullptr;
+            }
+            slots.splice(slots.begin(), slots, it->second);
+            return &*it->second;
+        }
+
+        void erase(const std::string& path)
+        {
+            if (const auto it = index.find(path); it != index.end())
+            {
+                // erase the key before the file it views
+                const auto slot = it->second;
+                index.erase(it);
+                slots.erase(slot);
+            }
+        }
+
+        void insert(std::shared_ptr<const internal::CachedFile> file, Clock::time_point now)
+        {
+            slots.push_front(CacheSlot{std::move(file), now});
+            index.emplace(slots.front().file->path, slots.begin());
+            if (slots.size() > capacity)
+            {
+                index.erase(slots.back().file->path);
+                slots.pop_back();
+            }
+        }
+    };
+
+    // the cached file is returned while it's fresh, else the path is stat'ed out of the lock
+    // and reopened only if it changed, so a hot file costs no syscall.
+    std::shared_ptr<const internal::CachedFile> lookup(const std::string& path, bool compressed) const
+    {
+        const auto now = Clock::now();
+        std::shared_ptr<const internal::CachedFile> cached;
+        {
+            std::lock_guard<std::mutex> lck(mCacheGuard);
+            auto slot = mOpenFiles.find(path);
+            if (slot == nullptr)
+            {
+                slot = mMissingFiles.find(path);
+            }
+            if (slot != nullptr)
+            {
+                if (now - slot->checkedAt < mStatInterval)
+                {
+                    return slot->file;
+                }
+                cached = slot->file;
+            }
+        }
+
+        internal::FileInfo info;
+        const auto exists = internal::StatFile(path, info);
+        if (cached != nullptr && exists == (cached->fd >= 0) &&
+            (!exists || (info.id == cached->info.id && info.size == cached->info.size && info.mtime == cached->info.mtime)))
+        {
+            std::lock_guard<std::mutex> lck(mCacheGuard);
+            auto slot = (exists ? mOpenFiles : mMissingFiles).find(path);
+            if (slot != nullptr && slot->file == cached)
+            {
+                slot->checkedAt = now;
+            }
+            return cached;
+        }
+
+        auto file = std::make_shared<internal::CachedFile>();
+        file->path = path;
+        if (exists)
+        {
+            file->fd = internal::OpenFile(path);
+            if (file->fd >= 0 && !internal::StatFile(file->fd, file->info))
+            {
+                internal::CloseFile(file->fd);
+                file->fd = -1;
+            }
+        }
+        if (file->fd >= 0)
+        {
+            // the encoded representation has its own tag
+            char etag[48];
+            const auto written = std::snprintf(etag, sizeof(etag), "\"%llx-%llx%s\"",
+                                               static_cast<unsigned long long>(file->info.mtime),
+                                               static_cast<unsigned long long>(file->info.size),
+                                               compressed ? "-gz" : "");
+            file->etag.assign(etag, static_cast<size_t>(written));
+            file->lastModified = FormatHttpDate(file->info.mtime);
+        }
+
+        // the descriptor of a replaced file is closed when its sends complete
+        std::lock_guard<std::mutex> lck(mCacheGuard);
+        mOpenFiles.erase(path);
+        mMissingFiles.erase(path);
+        (file->fd >= 0 ? mOpenFiles : mMissingFiles).insert(file, now);
+        return file;
+    }
+
+    static bool notModified(const HTTPParser& parser, const internal::CachedFile& file)
+    {
+        if (const auto ifNoneMatch = parser.header(HttpField::IfNoneMatch); !ifNoneMatch.empty())
+        {
+            return internal::MatchesETag(ifNoneMatch, file.etag);
+        }
+        const auto since = ParseHttpDate(parser.header(HttpField::IfModifiedSince));
+        return since && file.info.mtime <= *since;
+    }
+
+    // If-Range must match the current content, else the full content is sent.
+    static bool rangeMatches(const HTTPParser& parser, const internal::CachedFile& file)
+    {
+        const auto ifRange = parser.header(HttpField::IfRange);
+        return ifRange.empty() || ifRange == file.etag || ifRange == file.lastModified;
+    }
+
+    static void writeValidators(HttpResponseWriter& writer, const internal::CachedFile& file, bool hasCompressed)
+    {
+        writer.addHeader("ETag", file.etag);
+        writer.addHeader("Last-Modified", file.lastModified);
+        if (hasCompressed)
+        {
+            writer.addHeader("Vary", "Accept-Encoding");
+        }
+    }
+
+private:
+    std::string mRoot;
+    const std::chrono::milliseconds mStatInterval;
+    bool mPrecompressed = true;
+
+    mutable std::mutex mCacheGuard;
+    mutable CacheList mOpenFiles;
+    mutable CacheList mMissingFiles;
+};
+
+}// namespace bsio::net::http
@@ -48,18 +48,13 @@ public:
         return response;
     }
 
-    static bool wsFrameBuild(const char* payload,
-                             size_t payloadLen,
-                             std::string& frame,
-                             WebSocketFrameType frame_type = WebSocketFrameType::TEXT_FRAME,
-                             bool isFin = true,
-                             bool masking = false)
+    // the head of an unmasked frame, send it and a shared payload as segments of
+    // CompositeSendMsg, so the payload of a broadcast is not copied for every session.
+    static void wsFrameHeadBuild(size_t payloadLen,
+                                 std::string& frame,
+                                 WebSocketFrameType frame_type = WebSocketFrameType::TEXT_FRAME,
+                                 bool isFin = true)
     {
-        const static auto unixTime = std::chrono::system_clock::now().time_since_epoch().count();
-        static std::mt19937 random(static_cast<unsigned int>(unixTime));
-
-        static_assert(std::is_same<std::string::value_type, char>::value, "");
-
         const uint8_t head = static_cast<uint8_t>(frame_type) | (isFin ? 0x80 : 0x00);
 
         frame.clear();
@@ -90,6 +85,21 @@ public:
             frame.push_back(static_cast<char>((payloadLen & 0x0000FF00) >> 8));
             frame.push_back(static_cast<char>(payloadLen & 0x000000FF));
         }
+    }
+
+    static bool wsFrameBuild(const char* payload,
+                             size_t payloadLen,
+                             std::string& frame,
+                             WebSocketFrameType frame_type = WebSocketFrameType::TEXT_FRAME,
+                             bool isFin = true,
+                             bool masking = false)
+    {
+        const static auto unixTime = std::chrono::system_clock::now().time_since_epoch().count();
+        static std::mt19937 random(static_cast<unsigned int>(unixTime));
+
+        static_assert(std::is_same<std::string::value_type, char>::value, "");
+
+        wsFrameHeadBuild(payloadLen, frame, frame_type, isFin);
 
         if (masking)
         {
@@ -0,0 +1,7 @@
+#pragma once
+
+// define BSIO_USE_IO_URING to enable io_uring backend of TcpSession and TcpAcceptor,
+// it only takes effect on linux, and fallback to epoll if kernel does not support it.
+#if defined(BSIO_USE_IO_URING) && defined(__linux__)
+#define BSIO_HAS_IO_URING 1
+#endif
@@ -0,0 +1,276 @@
+#pragma once
+
+#include <algorithm>
+#include <asio.hpp>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace bsio::net::uring {
+
+// minimal io_uring ring built on raw syscalls, so there is no liburing dependency.
+// not thread safe, the owner must serialize access.
+class IoUring : private asio::noncopyable
+{
+public:
+    explicit IoUring(unsigned entries)
+    {
+        // not use IORING_SETUP_COOP_TASKRUN, completions must wake up the thread parked in epoll_wait.
+        io_uring_params params{};
+        mRingFd = setup(entries, params);
+        if (mRingFd < 0)
+        {
+            throw std::system_error(errno, std::system_category(), "io_uring_setup");
+        }
+        mFeatures = params.features;
+
+        try
+        {
+            mapRings(params);
+        }
+        catch (...)
+        {
+            unmapRings();
+            ::close(mRingFd);
+            throw;
+        }
+    }
+
+    ~IoUring()
+    {
+        unmapRings();
+        ::close(mRingFd);
+    }
+
+    int fd() const
+    {
+        return mRingFd;
+    }
+
+    uint32_t features() const
+    {
+        return mFeatures;
+    }
+
+    // return nullptr if submission queue is full.
+    io_uring_sqe* getSqe()
+    {
+        const auto head = loadAcquire(mSqHead);
+        if (mSqLocalTail - head >= mSqEntries)
+        {
+            return nullptr;
+        }
+        const auto index = mSqLocalTail & mSqMask;
+        auto sqe = &mSqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        mSqArray[index] = index;
+        mSqLocalTail++;
+        return sqe;
+    }
+
+    unsigned pendingSubmitNum() const
+    {
+        return mSqLocalTail - *mSqTail;
+    }
+
+    // return submitted num or -errno.
+    int submit(unsigned waitNum = 0)
+    {
+        const auto toSubmit = pendingSubmitNum();
+        storeRelease(mSqTail, mSqLocalTail);
+
+        unsigned flags = 0;
+        if (waitNum > 0 || cqOverflow())
+        {
+            flags |= IORING_ENTER_GETEVENTS;
+        }
+        if (toSubmit == 0 && flags == 0)
+        {
+            return 0;
+        }
+
+        int ret = 0;
+        do
+        {
+            ret = static_cast<int>(::syscall(__NR_io_uring_enter, mRingFd, toSubmit, waitNum, flags, nullptr, 0));
+        } while (ret < 0 && errno == EINTR);
+
+        return ret < 0 ? -errno : ret;
+    }
+
+    // call handler(const io_uring_cqe&) for every completion, return reaped num.
+    template<typename Handler>
+    unsigned reap(Handler&& handler)
+    {
+        unsigned num = 0;
+        auto head = *mCqHead;
+        while (true)
+        {
+            const auto tail = loadAcquire(mCqTail);
+            if (head == tail)
+            {
+                break;
+            }
+            for (; head != tail; head++, num++)
+            {
+                const auto cqe = mCqes[head & mCqMask];
+                // release the slot before handler, handler may submit new sqe.
+                storeRelease(mCqHead, head + 1);
+                handler(cqe);
+            }
+        }
+        return num;
+    }
+
+    bool cqOverflow() const
+    {
+        return (loadAcquire(mSqFlags) & IORING_SQ_CQ_OVERFLOW) != 0;
+    }
+
+    // suppress eventfd notification while completions are reaped inline.
+    void setEventFdEnabled(bool enabled)
+    {
+        if (mCqFlags == nullptr)
+        {
+            return;
+        }
+        auto flags = *mCqFlags;
+        flags = enabled ? (flags & ~IORING_CQ_EVENTFD_DISABLED) : (flags | IORING_CQ_EVENTFD_DISABLED);
+        storeRelease(mCqFlags, flags);
+    }
+
+    int registerEventFd(int eventFd)
+    {
+        return doRegister(IORING_REGISTER_EVENTFD, &eventFd, 1);
+    }
+
+    int registerBuffers(const iovec* iovecs, unsigned num)
+    {
+        return doRegister(IORING_REGISTER_BUFFERS, iovecs, num);
+    }
+
+    int registerBufferRing(io_uring_buf_reg& reg)
+    {
+        return doRegister(IORING_REGISTER_PBUF_RING, &reg, 1);
+    }
+
+private:
+    // ring indexes are shared with kernel
+    static unsigned loadAcquire(const unsigned* p)
+    {
+        return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+    }
+
+    static void storeRelease(unsigned* p, unsigned v)
+    {
+        __atomic_store_n(p, v, __ATOMIC_RELEASE);
+    }
+
+    static int setup(unsigned entries, io_uring_params& params)
+    {
+        return static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+    }
+
+    int doRegister(unsigned opcode, const void* arg, unsigned num)
+    {
+        const auto ret = ::syscall(__NR_io_uring_register, mRingFd, opcode, arg, num);
+        return ret < 0 ? -errno : 0;
+    }
+
+    void mapRings(const io_uring_params& params)
+    {
+        mSqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        mCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMmap)
+        {
+            mSqRingSize = mCqRingSize = std::max(mSqRingSize, mCqRingSize);
+        }
+
+        mSqRing = mapRing(mSqRingSize, IORING_OFF_SQ_RING);
+        mCqRing = singleMmap ? mSqRing : mapRing(mCqRingSize, IORING_OFF_CQ_RING);
+        mSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        mSqes = static_cast<io_uring_sqe*>(mapRing(mSqesSize, IORING_OFF_SQES));
+
+        auto sq = static_cast<char*>(mSqRing);
+        mSqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        mSqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        mSqFlags = reinterpret_cast<unsigned*>(sq + params.sq_off.flags);
+        mSqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        mSqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        mSqEntries = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_entries);
+        mSqLocalTail = *mSqTail;
+
+        auto cq = static_cast<char*>(mCqRing);
+        mCqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        mCqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        mCqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        mCqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        if (params.cq_off.flags != 0)
+        {
+            mCqFlags = reinterpret_cast<unsigned*>(cq + params.cq_off.flags);
+        }
+    }
+
+    void* mapRing(size_t size, off_t offset)
+    {
+        auto ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRingFd, offset);
+        if (ptr == MAP_FAILED)
+        {
+            throw std::system_error(errno, std::system_category(), "io_uring mmap");
+        }
+        return ptr;
+    }
+
+    void unmapRings()
+    {
+        if (mSqes != nullptr)
+        {
+            ::munmap(mSqes, mSqesSize);
+        }
+        if (mCqRing != nullptr && mCqRing != mSqRing)
+        {
+            ::munmap(mCqRing, mCqRingSize);
+        }
+        if (mSqRing != nullptr)
+        {
+            ::munmap(mSqRing, mSqRingSize);
+        }
+        mSqes = nullptr;
+        mSqRing = mCqRing = nullptr;
+    }
+
+private:
+    int mRingFd = -1;
+    uint32_t mFeatures = 0;
+
+    void* mSqRing = nullptr;
+    void* mCqRing = nullptr;
+    size_t mSqRingSize = 0;
+    size_t mCqRingSize = 0;
+    size_t mSqesSize = 0;
+
+    unsigned* mSqHead = nullptr;
+    unsigned* mSqTail = nullptr;
+    unsigned* mSqFlags = nullptr;
+    unsigned* mSqArray = nullptr;
+    unsigned mSqMask = 0;
+    unsigned mSqEntries = 0;
+    unsigned mSqLocalTail = 0;
+    io_uring_sqe* mSqes = nullptr;
+
+    unsigned* mCqHead = nullptr;
+    unsigned* mCqTail = nullptr;
+    unsigned* mCqFlags = nullptr;
+    unsigned mCqMask = 0;
+    io_uring_cqe* mCqes = nullptr;
+};
+
+}// namespace bsio::net::uring
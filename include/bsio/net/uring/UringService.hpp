@@ -0,0 +1,812 @@
+#pragma once
+
+#include <asio.hpp>
+#include <atomic>
+#include <bsio/net/HandlerMemory.hpp>
+#include <bsio/net/uring/IoUring.hpp>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <vector>
+
+namespace bsio::net::uring {
+
+struct UringOption final {
+    unsigned entries = 4096;
+    // small writes are copied into registered buffers and sent by IORING_OP_WRITE_FIXED.
+    unsigned fixedBufferNum = 256;
+    size_t fixedBufferSize = 16 * 1024;
+    // receive through a provided buffer ring(costs one memcpy into the session buffer,
+    // but no session buffer is referenced by kernel while the socket is idle).
+    bool useProvidedBuffers = false;
+    unsigned providedBufferNum = 1024;// must be power of 2
+    size_t providedBufferSize = 16 * 1024;
+};
+
+// per io_context io_uring, completions are delivered through an eventfd watched by
+// the io_context's reactor, submissions of all sessions are batched to one io_uring_enter
+// per io_context loop iteration.
+class UringService : public asio::execution_context::service
+{
+public:
+    using key_type = UringService;
+    inline static asio::execution_context::id id;
+
+    explicit UringService(asio::execution_context& context)
+        : asio::execution_context::service(context),
+          mIoContext(static_cast<asio::io_context&>(context)),
+          mEventDescriptor(mIoContext)
+    {
+        try
+        {
+            init(DefaultOption());
+        }
+        catch (const std::exception& e)
+        {
+            // kernel not support or forbidden by seccomp, fallback to reactor.
+            std::cerr << "io_uring is unavailable, fallback to epoll:" << e.what() << std::endl;
+            release();
+        }
+    }
+
+    ~UringService() override
+    {
+        release();
+    }
+
+    // option of services created after this call.
+    static UringOption& DefaultOption()
+    {
+        static UringOption option;
+        return option;
+    }
+
+    static UringService* Get(asio::execution_context& context)
+    {
+        auto& service = asio::use_service<UringService>(context);
+        return service.mRing != nullptr ? &service : nullptr;
+    }
+
+    // handler(std::error_code, size_t), eof is reported as asio::error::eof.
+    template<typename Handler>
+    void asyncReceive(int fd, asio::mutable_buffer buffer, Handler handler)
+    {
+        auto op = ReceiveOp<Handler>::Make(std::move(handler), fd, buffer);
+        op->useProvidedBuffer = mProvidedBufferRing != nullptr;
+        std::lock_guard<std::mutex> lck(mSqGuard);
+        linkOp(op);
+        prepareReceive(*op);
+    }
+
+    // write all buffers, handler(std::error_code, size_t).
+    template<typename Handler>
+    void asyncWrite(int fd, const std::vector<asio::const_buffer>& buffers, Handler handler)
+    {
+        size_t total = 0;
+        for (const auto& buffer : buffers)
+        {
+            total += buffer.size();
+        }
+        if (total == 0)
+        {
+            asio::post(mIoContext, [handler = std::move(handler)]() mutable {
+                handler(std::error_code(), 0);
+            });
+            return;
+        }
+
+        auto op = WriteOp<Handler>::Make(std::move(handler), fd);
+
+        std::lock_guard<std::mutex> lck(mSqGuard);
+        linkOp(op);
+        if (total <= mFixedBufferSize && !mFreeFixedBuffers.empty())
+        {
+            op->fixedIndex = mFreeFixedBuffers.back();
+            mFreeFixedBuffers.pop_back();
+            auto dst = static_cast<char*>(mFixedBuffers[op->fixedIndex].iov_base);
+            for (const auto& buffer : buffers)
+            {
+                std::memcpy(dst, buffer.data(), buffer.size());
+                dst += buffer.size();
+            }
+            op->allocateIovecs(1)[0] = {mFixedBuffers[op->fixedIndex].iov_base, total};
+        }
+        else
+        {
+            auto iov = op->allocateIovecs(buffers.size());
+            for (const auto& buffer : buffers)
+            {
+                *iov++ = {const_cast<void*>(buffer.data()), buffer.size()};
+            }
+        }
+        prepareWrite(*op);
+    }
+
+    // handler(std::error_code, int fd) is called for every accepted connection,
+    // listen fd must be closed or cancel() to finish it. it's also finished by an error
+    // except transient ones, the handler is called with the error then.
+    template<typename Handler>
+    void asyncAcceptMultishot(int listenFd, Handler handler)
+    {
+        auto op = AcceptOp<Handler>::Make(std::move(handler), listenFd);
+        std::lock_guard<std::mutex> lck(mSqGuard);
+        linkOp(op);
+        prepareAccept(*op);
+    }
+
+    // cancel all pending operations of fd.
+    void cancel(int fd)
+    {
+        std::lock_guard<std::mutex> lck(mSqGuard);
+        auto sqe = getSqe();
+        if (sqe == nullptr)
+        {
+            // kernel holds the file of pending operations, shutdown the socket to finish them.
+            ::shutdown(fd, SHUT_RDWR);
+            return;
+        }
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = fd;
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+        sqe->user_data = 0;
+        // cancel must reach kernel before fd is closed.
+        mRing->submit();
+    }
+
+private:
+    struct Op {
+        virtual ~Op() = default;
+        // the operation releases itself by finish() when it's done.
+        virtual void complete(UringService& service, const io_uring_cqe& cqe) = 0;
+        // release without calling the handler.
+        virtual void destroy() = 0;
+
+        Op* prev = nullptr;
+        Op* next = nullptr;
+    };
+
+    // operations are allocated by the associated allocator of their handlers, so the recurring
+    // operations of a session reuse its handler memory. the memory is released before the
+    // handler is called, then the handler can start the next operation in it.
+    template<typename Derived, typename Handler>
+    struct HandlerOp : public Op {
+        using Allocator = typename std::allocator_traits<asio::associated_allocator_t<Handler>>::template rebind_alloc<Derived>;
+
+        explicit HandlerOp(Handler h)
+            : handler(std::move(h))
+        {
+        }
+
+        template<typename... Args>
+        static Derived* Make(Handler handler, Args&&... args)
+        {
+            Allocator allocator(asio::get_associated_allocator(handler));
+            const auto p = allocator.allocate(1);
+            try
+            {
+                return new (p) Derived(std::move(handler), std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                allocator.deallocate(p, 1);
+                throw;
+            }
+        }
+
+        void destroy() override
+        {
+            Allocator allocator(asio::get_associated_allocator(handler));
+            const auto self = static_cast<Derived*>(this);
+            self->~Derived();
+            allocator.deallocate(self, 1);
+        }
+
+        template<typename... Args>
+        void finish(UringService& service, Args... args)
+        {
+            auto h = std::move(handler);
+            service.unlinkOp(this);
+            destroy();
+            h(args...);
+        }
+
+        Handler handler;
+    };
+
+    template<typename Handler>
+    struct ReceiveOp : public HandlerOp<ReceiveOp<Handler>, Handler> {
+        ReceiveOp(Handler h, int f, asio::mutable_buffer b)
+            : HandlerOp<ReceiveOp<Handler>, Handler>(std::move(h)),
+              fd(f),
+              buffer(b)
+        {
+        }
+
+        void complete(UringService& service, const io_uring_cqe& cqe) override
+        {
+            if (cqe.res == -ENOBUFS && useProvidedBuffer)
+            {
+                // buffer ring is exhausted, receive into session buffer directly.
+                useProvidedBuffer = false;
+                std::lock_guard<std::mutex> lck(service.mSqGuard);
+                service.prepareReceive(*this);
+                return;
+            }
+
+            size_t len = 0;
+            if (cqe.res > 0)
+            {
+                len = static_cast<size_t>(cqe.res);
+                if (cqe.flags & IORING_CQE_F_BUFFER)
+                {
+                    const auto bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+                    std::memcpy(buffer.data(), service.providedBuffer(bid), len);
+                    service.recycleProvidedBuffer(bid);
+                }
+            }
+            this->finish(service, MakeErrorCode(cqe.res, asio::error::eof), len);
+        }
+
+        int fd;
+        asio::mutable_buffer buffer;
+        bool useProvidedBuffer = false;
+    };
+
+    template<typename Handler>
+    struct WriteOp : public HandlerOp<WriteOp<Handler>, Handler> {
+        // enough for most gathered writes of a session
+        static constexpr size_t InlineIovecNum = 8;
+
+        WriteOp(Handler h, int f)
+            : HandlerOp<WriteOp<Handler>, Handler>(std::move(h)),
+              fd(f)
+        {
+        }
+
+        iovec* allocateIovecs(size_t num)
+        {
+            if (num > InlineIovecNum)
+            {
+                heapIovecs.reset(new iovec[num]);
+                iovecs = heapIovecs.get();
+            }
+            iovecNum = num;
+            return iovecs;
+        }
+
+        void complete(UringService& service, const io_uring_cqe& cqe) override
+        {
+            if (cqe.res > 0)
+            {
+                written += static_cast<size_t>(cqe.res);
+                auto left = static_cast<size_t>(cqe.res);
+                while (left > 0 && offset < iovecNum)
+                {
+                    auto& iov = iovecs[offset];
+                    const auto n = std::min(left, iov.iov_len);
+                    iov.iov_base = static_cast<char*>(iov.iov_base) + n;
+                    iov.iov_len -= n;
+                    left -= n;
+                    if (iov.iov_len == 0)
+                    {
+                        offset++;
+                    }
+                }
+                if (offset < iovecNum)
+                {
+                    // short write, continue with the remained data
+                    std::lock_guard<std::mutex> lck(service.mSqGuard);
+                    service.prepareWrite(*this);
+                    return;
+                }
+            }
+
+            if (fixedIndex >= 0)
+            {
+                std::lock_guard<std::mutex> lck(service.mSqGuard);
+                service.mFreeFixedBuffers.push_back(fixedIndex);
+            }
+            this->finish(service, MakeErrorCode(cqe.res, asio::error::broken_pipe), written);
+        }
+
+        int fd;
+        iovec inlineIovecs[InlineIovecNum];
+        std::unique_ptr<iovec[]> heapIovecs;
+        iovec* iovecs = inlineIovecs;
+        size_t iovecNum = 0;
+        size_t offset = 0;
+        size_t written = 0;
+        int fixedIndex = -1;
+    };
+
+    template<typename Handler>
+    struct AcceptOp : public HandlerOp<AcceptOp<Handler>, Handler> {
+        AcceptOp(Handler h, int f)
+            : HandlerOp<AcceptOp<Handler>, Handler>(std::move(h)),
+              fd(f)
+        {
+        }
+
+        void complete(UringService& service, const io_uring_cqe& cqe) override
+        {
+            if (cqe.res == -EINVAL && multishot)
+            {
+                // kernel older than 5.19, use single shot accept
+                multishot = false;
+                std::lock_guard<std::mutex> lck(service.mSqGuard);
+                service.prepareAccept(*this);
+                return;
+            }
+            if (cqe.res >= 0)
+            {
+                this->handler(std::error_code(), cqe.res);
+            }
+            else if (cqe.res != -EAGAIN && cqe.res != -EINTR && cqe.res != -ECONNABORTED &&
+                     cqe.res != -EMFILE && cqe.res != -ENFILE)
+            {
+                this->finish(service, MakeErrorCode(cqe.res, asio::error::eof), -1);
+                return;
+            }
+
+            if (!(cqe.flags & IORING_CQE_F_MORE))
+            {
+                std::lock_guard<std::mutex> lck(service.mSqGuard);
+                service.prepareAccept(*this);
+            }
+        }
+
+        int fd;
+        bool multishot = true;
+    };
+
+    static std::error_code MakeErrorCode(int res, asio::error::misc_errors zeroError)
+    {
+        if (res > 0)
+        {
+            return std::error_code();
+        }
+        if (res == 0)
+        {
+            return zeroError;
+        }
+        if (res == -ECANCELED)
+        {
+            return asio::error::operation_aborted;
+        }
+        return std::error_code(-res, asio::error::get_system_category());
+    }
+
+    static std::error_code MakeErrorCode(int res, asio::error::basic_errors zeroError)
+    {
+        if (res == 0)
+        {
+            return zeroError;
+        }
+        return MakeErrorCode(res, asio::error::eof);
+    }
+
+    void init(const UringOption& option)
+    {
+        mRing = std::make_unique<IoUring>(option.entries);
+
+        mEventFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (mEventFd < 0)
+        {
+            throw std::system_error(errno, std::system_category(), "eventfd");
+        }
+        mEventDescriptor.assign(mEventFd);
+        if (auto ret = mRing->registerEventFd(mEventFd); ret < 0)
+        {
+            throw std::system_error(-ret, std::system_category(), "register eventfd");
+        }
+
+        initFixedBuffers(option);
+        if (option.useProvidedBuffers)
+        {
+            initProvidedBuffers(option);
+        }
+
+        waitCompletion();
+    }
+
+    void initFixedBuffers(const UringOption& option)
+    {
+        if (option.fixedBufferNum == 0 || option.fixedBufferSize == 0)
+        {
+            return;
+        }
+        mFixedBufferMemory.reset(new char[option.fixedBufferNum * option.fixedBufferSize]);
+        for (unsigned i = 0; i < option.fixedBufferNum; i++)
+        {
+            mFixedBuffers.push_back({mFixedBufferMemory.get() + i * option.fixedBufferSize, option.fixedBufferSize});
+        }
+        if (mRing->registerBuffers(mFixedBuffers.data(), static_cast<unsigned>(mFixedBuffers.size())) < 0)
+        {
+            // RLIMIT_MEMLOCK is too small, go without fixed buffers.
+            mFixedBuffers.clear();
+            mFixedBufferMemory.reset();
+            return;
+        }
+        mFixedBufferSize = option.fixedBufferSize;
+        for (int i = static_cast<int>(mFixedBuffers.size()) - 1; i >= 0; i--)
+        {
+            mFreeFixedBuffers.push_back(i);
+        }
+    }
+
+    void initProvidedBuffers(const UringOption& option)
+    {
+        const auto num = option.providedBufferNum;
+        if (num == 0 || (num & (num - 1)) != 0 || num > 32768)
+        {
+            throw std::runtime_error("provided buffer num must be power of 2 and not larger than 32768");
+        }
+
+        const auto ringSize = num * sizeof(io_uring_buf);
+        auto ring = ::mmap(nullptr, ringSize, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+        if (ring == MAP_FAILED)
+        {
+            throw std::system_error(errno, std::system_category(), "mmap buffer ring");
+        }
+        mProvidedBufferRing = static_cast<io_uring_buf_ring*>(ring);
+        mProvidedBufferRingSize = ringSize;
+        mProvidedBufferMask = num - 1;
+        mProvidedBufferSize = option.providedBufferSize;
+        mProvidedBufferMemory.reset(new char[num * option.providedBufferSize]);
+
+        io_uring_buf_reg reg{};
+        reg.ring_addr = reinterpret_cast<uint64_t>(ring);
+        reg.ring_entries = num;
+        reg.bgid = ProvidedBufferGroup;
+        if (mRing->registerBufferRing(reg) < 0)
+        {
+            // kernel older than 5.19
+            releaseProvidedBuffers();
+            return;
+        }
+
+        for (unsigned i = 0; i < num; i++)
+        {
+            addProvidedBuffer(static_cast<uint16_t>(i), static_cast<uint16_t>(i));
+        }
+        __atomic_store_n(&mProvidedBufferRing->tail, static_cast<uint16_t>(num), __ATOMIC_RELEASE);
+        mProvidedBufferTail = static_cast<uint16_t>(num);
+    }
+
+    char* providedBuffer(uint16_t bid) const
+    {
+        return mProvidedBufferMemory.get() + bid * mProvidedBufferSize;
+    }
+
+    void addProvidedBuffer(uint16_t bid, uint16_t offset)
+    {
+        auto& buf = mProvidedBufferRing->bufs[offset & mProvidedBufferMask];
+        buf.addr = reinterpret_cast<uint64_t>(providedBuffer(bid));
+        buf.len = static_cast<uint32_t>(mProvidedBufferSize);
+        buf.bid = bid;
+    }
+
+    // only called in completion handler, which is serialized by mReapGuard.
+    void recycleProvidedBuffer(uint16_t bid)
+    {
+        addProvidedBuffer(bid, mProvidedBufferTail);
+        mProvidedBufferTail++;
+        __atomic_store_n(&mProvidedBufferRing->tail, mProvidedBufferTail, __ATOMIC_RELEASE);
+    }
+
+    void releaseProvidedBuffers()
+    {
+        if (mProvidedBufferRing != nullptr)
+        {
+            ::munmap(mProvidedBufferRing, mProvidedBufferRingSize);
+            mProvidedBufferRing = nullptr;
+        }
+        mProvidedBufferMemory.reset();
+    }
+
+    // must hold mSqGuard, return nullptr if the full submission queue can't be flushed, such as
+    // completion queue is full(-EBUSY), the caller fails its operation by failOp then.
+    io_uring_sqe* getSqe()
+    {
+        auto sqe = mRing->getSqe();
+        if (sqe == nullptr)
+        {
+            // submission queue is full, flush it now.
+            if (const auto ret = mRing->submit(); ret < 0 && ret != -EBUSY && ret != -EAGAIN)
+            {
+                std::cerr << "io_uring_enter failed:" << ret << std::endl;
+            }
+            sqe = mRing->getSqe();
+        }
+        // also delivers failures of operations
+        if (!mSubmitPosted)
+        {
+            mSubmitPosted = true;
+            asio::post(mIoContext, MakeAllocHandler(mSubmitHandlerMemory, [this]() {
+                           submitPending();
+                       }));
+        }
+        return sqe;
+    }
+
+    // must hold mSqGuard, complete the operation with error res in processCompletions.
+    void failOp(Op& op, int res)
+    {
+        io_uring_cqe cqe{};
+        cqe.user_data = reinterpret_cast<uint64_t>(&op);
+        cqe.res = res;
+        mFailedCompletions.push_back(cqe);
+        mHasFailedOps.store(true);
+    }
+
+    void submitPending()
+    {
+        // completions of inline finished operations are ready after submit,
+        // reap them directly instead of waking up by eventfd.
+        mRing->setEventFdEnabled(false);
+        {
+            std::lock_guard<std::mutex> lck(mSqGuard);
+            mSubmitPosted = false;
+            const auto ret = mRing->submit();
+            if (ret < 0 && ret != -EBUSY && ret != -EAGAIN)
+            {
+                std::cerr << "io_uring_enter failed:" << ret << std::endl;
+            }
+        }
+        processCompletions();
+        mRing->setEventFdEnabled(true);
+        // completions posted while eventfd is disabled
+        processCompletions();
+    }
+
+    template<typename Handler>
+    void prepareReceive(ReceiveOp<Handler>& op)
+    {
+        auto sqe = getSqe();
+        if (sqe == nullptr)
+        {
+            failOp(op, -EBUSY);
+            return;
+        }
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = op.fd;
+        sqe->user_data = reinterpret_cast<uint64_t>(static_cast<Op*>(&op));
+        if (op.useProvidedBuffer)
+        {
+            sqe->flags |= IOSQE_BUFFER_SELECT;
+            sqe->buf_group = ProvidedBufferGroup;
+            sqe->len = static_cast<uint32_t>(std::min(op.buffer.size(), mProvidedBufferSize));
+        }
+        else
+        {
+            sqe->addr = reinterpret_cast<uint64_t>(op.buffer.data());
+            sqe->len = static_cast<uint32_t>(op.buffer.size());
+        }
+    }
+
+    template<typename Handler>
+    void prepareWrite(WriteOp<Handler>& op)
+    {
+        auto sqe = getSqe();
+        if (sqe == nullptr)
+        {
+            failOp(op, -EBUSY);
+            return;
+        }
+        sqe->fd = op.fd;
+        sqe->user_data = reinterpret_cast<uint64_t>(static_cast<Op*>(&op));
+        sqe->off = static_cast<uint64_t>(-1);
+        if (op.fixedIndex >= 0)
+        {
+            sqe->opcode = IORING_OP_WRITE_FIXED;
+            sqe->addr = reinterpret_cast<uint64_t>(op.iovecs[0].iov_base);
+            sqe->len = static_cast<uint32_t>(op.iovecs[0].iov_len);
+            sqe->buf_index = static_cast<uint16_t>(op.fixedIndex);
+        }
+        else
+        {
+            sqe->opcode = IORING_OP_WRITEV;
+            sqe->addr = reinterpret_cast<uint64_t>(op.iovecs + op.offset);
+            sqe->len = static_cast<uint32_t>(std::min<size_t>(op.iovecNum - op.offset, IOV_MAX));
+        }
+    }
+
+    template<typename Handler>
+    void prepareAccept(AcceptOp<Handler>& op)
+    {
+        auto sqe = getSqe();
+        if (sqe == nullptr)
+        {
+            failOp(op, -EBUSY);
+            return;
+        }
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = op.fd;
+        sqe->accept_flags = SOCK_CLOEXEC;
+        sqe->ioprio = op.multishot ? IORING_ACCEPT_MULTISHOT : 0;
+        sqe->user_data = reinterpret_cast<uint64_t>(static_cast<Op*>(&op));
+    }
+
+    // must hold mSqGuard
+    void linkOp(Op* op)
+    {
+        op->next = mOps;
+        if (mOps != nullptr)
+        {
+            mOps->prev = op;
+        }
+        mOps = op;
+        mOpNum++;
+    }
+
+    void unlinkOp(Op* op)
+    {
+        std::lock_guard<std::mutex> lck(mSqGuard);
+        if (op->prev != nullptr)
+        {
+            op->prev->next = op->next;
+        }
+        else
+        {
+            mOps = op->next;
+        }
+        if (op->next != nullptr)
+        {
+            op->next->prev = op->prev;
+        }
+        mOpNum--;
+    }
+
+    void waitCompletion()
+    {
+        mEventDescriptor.async_wait(asio::posix::stream_descriptor::wait_read,
+                                    MakeAllocHandler(mWaitHandlerMemory,
+                                                     [this](std::error_code ec) {
+                                                         if (ec)
+                                                         {
+                                                             return;
+                                                         }
+                                                         uint64_t value = 0;
+                                                         (void) ::read(mEventFd, &value, sizeof(value));
+                                                         processCompletions();
+                                                         waitCompletion();
+                                                     }));
+    }
+
+    void processCompletions()
+    {
+        // completions may be processed by eventfd handler and submit task concurrently
+        // when several threads run the io_context, the one holds mReapGuard process them all.
+        mReapRequested.store(true);
+        while (mReapRequested.load())
+        {
+            std::unique_lock<std::mutex> reapLck(mReapGuard, std::try_to_lock);
+            if (!reapLck.owns_lock())
+            {
+                return;
+            }
+            mReapRequested.store(false);
+
+            if (mHasFailedOps.load())
+            {
+                std::lock_guard<std::mutex> lck(mSqGuard);
+                mCompletions.swap(mFailedCompletions);
+                mHasFailedOps.store(false);
+            }
+            mRing->reap([this](const io_uring_cqe& cqe) {
+                mCompletions.push_back(cqe);
+            });
+            for (const auto& cqe : mCompletions)
+            {
+                auto op = reinterpret_cast<Op*>(cqe.user_data);
+                if (op == nullptr)
+                {
+                    continue;
+                }
+                op->complete(*this, cqe);
+            }
+            mCompletions.clear();
+
+            if (mRing->cqOverflow())
+            {
+                std::lock_guard<std::mutex> lck(mSqGuard);
+                mRing->submit();
+                mReapRequested.store(true);
+            }
+        }
+    }
+
+    void shutdown() override
+    {
+        if (mRing == nullptr)
+        {
+            return;
+        }
+
+        // kernel may still reference buffers owned by pending operations,
+        // so cancel them and wait their completions before destroy them.
+        {
+            std::lock_guard<std::mutex> lck(mSqGuard);
+            if (auto sqe = mRing->getSqe(); sqe != nullptr)
+            {
+                sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY | IORING_ASYNC_CANCEL_ALL;
+                sqe->user_data = 0;
+            }
+        }
+        for (int i = 0; i < 100 && mOpNum > 0; i++)
+        {
+            mRing->submit(1);
+            mRing->reap([this](const io_uring_cqe& cqe) {
+                auto op = reinterpret_cast<Op*>(cqe.user_data);
+                if (op != nullptr && !(cqe.flags & IORING_CQE_F_MORE))
+                {
+                    unlinkOp(op);
+                    op->destroy();
+                }
+            });
+        }
+        // failed operations are not referenced by kernel
+        for (const auto& cqe : mFailedCompletions)
+        {
+            auto op = reinterpret_cast<Op*>(cqe.user_data);
+            unlinkOp(op);
+            op->destroy();
+        }
+        mFailedCompletions.clear();
+
+        mEventDescriptor.close();
+    }
+
+    void release()
+    {
+        if (mEventFd >= 0)
+        {
+            asio::error_code ec;
+            mEventDescriptor.close(ec);
+            mEventFd = -1;
+        }
+        releaseProvidedBuffers();
+        mRing.reset();
+        mFixedBuffers.clear();
+        mFixedBufferMemory.reset();
+    }
+
+private:
+    static constexpr uint16_t ProvidedBufferGroup = 0;
+
+    asio::io_context& mIoContext;
+    std::unique_ptr<IoUring> mRing;
+    int mEventFd = -1;
+    // declared before the descriptor, which may release the pending wait on destroy.
+    HandlerMemory<256> mWaitHandlerMemory;
+    asio::posix::stream_descriptor mEventDescriptor;
+
+    std::mutex mSqGuard;
+    bool mSubmitPosted = false;
+    HandlerMemory<128> mSubmitHandlerMemory;
+    Op* mOps = nullptr;
+    size_t mOpNum = 0;
+    std::mutex mReapGuard;
+    std::atomic_bool mReapRequested = {false};
+    std::vector<io_uring_cqe> mCompletions;
+    // guarded by mSqGuard
+    std::vector<io_uring_cqe> mFailedCompletions;
+    std::atomic_bool mHasFailedOps = {false};
+
+    std::unique_ptr<char[]> mFixedBufferMemory;
+    std::vector<iovec> mFixedBuffers;
+    std::vector<int> mFreeFixedBuffers;
+    size_t mFixedBufferSize = 0;
+
+    io_uring_buf_ring* mProvidedBufferRing = nullptr;
+    size_t mProvidedBufferRingSize = 0;
+    std::unique_ptr<char[]> mProvidedBufferMemory;
+    size_t mProvidedBufferSize = 0;
+    uint16_t mProvidedBufferMask = 0;
+    uint16_t mProvidedBufferTail = 0;
+};
+
+}// namespace bsio::net::uring
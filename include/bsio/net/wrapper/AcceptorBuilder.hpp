@@ -53,15 +53,29 @@ public:
 
         auto establishHandler = [builderCallback = mSessionOptionBuilderCallback,
                                  receiveBufferSize = mReceiveBufferSize](asio::ip::tcp::socket socket) {
-            SessionOptionBuilder option;
-            builderCallback(option);
+            SessionOptionBuilder builder;
+            builderCallback(builder);
+            auto option = builder.TakeOption();
 
             const auto session = TcpSession::Make(std::move(socket),
                                                   receiveBufferSize,
-                                                  option.Option().dataHandler,
-                                                  option.Option().closedHandler,
-                                                  option.Option().eofHandler);
-            for (const auto &callback : option.Option().establishHandlers)
+                                                  std::move(option.dataHandler),
+                                                  std::move(option.closedHandler),
+                                                  std::move(option.eofHandler),
+                                                  option.useStrand);
+            if (option.memoryBudget != nullptr)
+            {
+                session->setMemoryBudget(std::move(option.memoryBudget));
+            }
+            if (option.userDataInit != nullptr)
+            {
+                option.userDataInit(*session);
+            }
+            if (option.timeout.enabled())
+            {
+                session->setTimeout(option.timeout);
+            }
+            for (const auto &callback : option.establishHandlers)
             {
                 callback(session);
             }
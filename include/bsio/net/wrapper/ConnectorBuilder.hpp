@@ -74,7 +74,20 @@ public:
                             receiveBufferSize,
                             option.dataHandler,
                             option.closedHandler,
-                            option.eofHandler);
+                            option.eofHandler,
+                            option.useStrand);
+                    if (option.memoryBudget != nullptr)
+                    {
+                        session->setMemoryBudget(option.memoryBudget);
+                    }
+                    if (option.userDataInit != nullptr)
+                    {
+                        option.userDataInit(*session);
+                    }
+                    if (option.timeout.enabled())
+                    {
+                        session->setTimeout(option.timeout);
+                    }
                     for (const auto& callback : option.establishHandlers)
                     {
                         callback(session);
@@ -54,11 +54,14 @@ public:
             callback(httpBuilder);
 
             auto httpSession = std::make_shared<http::HttpSession>(nullptr, httpBuilder.ParserCallback(), httpBuilder.WsCallback(), nullptr, httpBuilder.ClosedCallback());
-            auto [dataHandler, eofHandler, closedHandler] = internal::makeHttpHandlers(httpSession);
+            httpSession->setStreamingCallback(httpBuilder.HeadersCallback(), httpBuilder.BodyChunkCallback());
+            auto [dataHandler, eofHandler, closedHandler] = internal::makeHttpHandlers(httpSession, httpBuilder.ZeroCopyParser());
 
             sessionBuilder.WithDataHandler(dataHandler);
             sessionBuilder.WithEofHandler(eofHandler);
             sessionBuilder.WithClosedHandler(closedHandler);
+            sessionBuilder.WithUserDataInit(httpBuilder.UserDataInit());
+            sessionBuilder.WithMemoryBudget(httpBuilder.MemoryBudget());
 
             sessionBuilder.AddEstablishHandler([=, enterCallback = httpBuilder.EnterCallback()](TcpSession::Ptr session) {
                 httpSession->setSession(session);
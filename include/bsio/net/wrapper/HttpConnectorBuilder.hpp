@@ -51,11 +51,14 @@ public:
     void asyncConnect()
     {
         auto httpSession = std::make_shared<http::HttpSession>(nullptr, ParserCallback(), WsCallback(), nullptr, ClosedCallback());
-        auto [dataHandler, eofHandler, closedHandler] = internal::makeHttpHandlers(httpSession);
+        httpSession->setStreamingCallback(HeadersCallback(), BodyChunkCallback());
+        auto [dataHandler, eofHandler, closedHandler] = internal::makeHttpHandlers(httpSession, ZeroCopyParser());
 
         mSessionConnectorBuilder.WithDataHandler(dataHandler);
         mSessionConnectorBuilder.WithEofHandler(eofHandler);
         mSessionConnectorBuilder.WithClosedHandler(closedHandler);
+        mSessionConnectorBuilder.WithUserDataInit(UserDataInit());
+        mSessionConnectorBuilder.WithMemoryBudget(MemoryBudget());
 
         mSessionConnectorBuilder.AddEstablishHandler([enterCallback = EnterCallback(), httpSession](TcpSession::Ptr session) {
             httpSession->setSession(session);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <bsio/net/Functor.hpp>
+#include <bsio/net/http/HttpRouter.hpp>
 #include <bsio/net/http/HttpService.hpp>
 #include <bsio/net/wrapper/internal/Option.hpp>
 #include <tuple>
@@ -23,6 +24,17 @@ public:
         return static_cast<Derived&>(*this);
     }
 
+    // requests are dispatched by router instead of a parser callback, the router is
+    // shared by sessions, so routes must be added before start.
+    Derived& WithRouter(http::HttpRouter::Ptr router) noexcept
+    {
+        mParserCallback = [router = std::move(router)](const http::HTTPParser& parser,
+                                                       const http::HttpSession::Ptr& session) {
+            router->dispatch(parser, session);
+        };
+        return static_cast<Derived&>(*this);
+    }
+
     Derived& WithWsCallback(http::HttpSession::WsCallback handler) noexcept
     {
         mWsCallback = std::move(handler);
@@ -35,6 +47,39 @@ public:
         return static_cast<Derived&>(*this);
     }
 
+    // construct user data of type T in the slot of every session, HttpSession::userData<T>() returns it.
+    template<typename T, typename... Args>
+    Derived& WithUserData(Args... args)
+    {
+        mUserDataInit = [=](TcpSession& session) {
+            session.emplaceUserData<T>(args...);
+        };
+        return static_cast<Derived&>(*this);
+    }
+
+    Derived& WithMemoryBudget(net::MemoryBudget::Ptr budget) noexcept
+    {
+        mMemoryBudget = std::move(budget);
+        return static_cast<Derived&>(*this);
+    }
+
+    // body of message is passed to BodyChunkCallback in pieces instead of being accumulated,
+    // call HttpSession::pauseRecv in the callback to stop reading until resumeRecv.
+    Derived& WithStreamingBody(http::HttpSession::HeadersCallback headersCallback,
+                               http::HttpSession::BodyChunkCallback bodyChunkCallback) noexcept
+    {
+        mHeadersCallback = std::move(headersCallback);
+        mBodyChunkCallback = std::move(bodyChunkCallback);
+        return static_cast<Derived&>(*this);
+    }
+
+    // headers and body of request are views of receive buffer in parser callback, see HTTPParser.
+    Derived& WithZeroCopyParser() noexcept
+    {
+        mZeroCopyParser = true;
+        return static_cast<Derived&>(*this);
+    }
+
     const auto& EnterCallback() const
     {
         return mEnterCallback;
@@ -55,49 +100,106 @@ public:
         return mClosedCallback;
     }
 
+    const auto& UserDataInit() const
+    {
+        return mUserDataInit;
+    }
+
+    const auto& HeadersCallback() const
+    {
+        return mHeadersCallback;
+    }
+
+    const auto& BodyChunkCallback() const
+    {
+        return mBodyChunkCallback;
+    }
+
+    const auto& MemoryBudget() const
+    {
+        return mMemoryBudget;
+    }
+
+    bool ZeroCopyParser() const
+    {
+        return mZeroCopyParser;
+    }
+
 private:
     http::HttpSession::EnterCallback mEnterCallback;
     http::HttpSession::HttpParserCallback mParserCallback;
     http::HttpSession::WsCallback mWsCallback;
     http::HttpSession::ClosedCallback mClosedCallback;
+    http::HttpSession::HeadersCallback mHeadersCallback;
+    http::HttpSession::BodyChunkCallback mBodyChunkCallback;
+    TcpSession::UserDataInit mUserDataInit;
+    net::MemoryBudget::Ptr mMemoryBudget;
+    bool mZeroCopyParser = false;
 };
 
-std::tuple<TcpSession::DataHandler, TcpSession::EofHandler, TcpSession::ClosedHandler> makeHttpHandlers(http::HttpSession::Ptr httpSession)
+std::tuple<TcpSession::DataHandler, TcpSession::EofHandler, TcpSession::ClosedHandler> makeHttpHandlers(http::HttpSession::Ptr httpSession,
+                                                                                                        bool zeroCopyParser = false)
 {
-    auto httpParser = std::make_shared<http::HTTPParser>(HTTP_BOTH);
+    auto httpParser = std::make_shared<http::HTTPParser>(HTTP_BOTH, zeroCopyParser);
+    if (httpSession->getBodyChunkCallback() != nullptr)
+    {
+        httpParser->setBodyStreaming(
+                [=](const http::HTTPParser& parser) {
+                    if (const auto& callback = httpSession->getHeadersCallback())
+                    {
+                        callback(parser, httpSession);
+                    }
+                },
+                [=](const http::HTTPParser& parser, std::string_view chunk) {
+                    httpSession->getBodyChunkCallback()(parser, httpSession, chunk);
+                    // the rest of buffer is parsed after resumeRecv
+                    return !httpSession->recvPaused();
+                });
+    }
 
     auto dataHandler = [=](const TcpSession::Ptr& session, bsio::base::BasePacketReader& reader) {
         (void) session;
 
-        size_t retLen = 0;
-
-
-        if (httpParser->isWebSocket())
+        const char* buffer = reader.begin();
+        size_t leftLen = reader.size();
+        while (leftLen > 0)
         {
-            retLen = http::HttpService::ProcessWebSocket(reader.begin(),
-                                                         reader.size(),
-                                                         httpParser,
-                                                         httpSession);
-        }
-        else if (httpParser->isUpgrade())
-        {
-            // TODO::not support other upgrade protocol
-        }
-        else
-        {
-            retLen = http::HttpService::ProcessHttp(reader.begin(),
-                                                    reader.size(),
-                                                    httpParser,
-                                                    httpSession);
-            // if http_parser_execute not consume all data that indicate cause error in parser.
-            // so we need close connection.
-            if (retLen != reader.size())
+            if (httpParser->isWebSocket())
+            {
+                const auto retLen = http::HttpService::ProcessWebSocket(buffer,
+                                                                        leftLen,
+                                                                        httpParser,
+                                                                        httpSession);
+                buffer += retLen;
+                leftLen -= retLen;
+                break;
+            }
+            if (httpParser->isUpgrade())
+            {
+                // TODO::not support other upgrade protocol
+                break;
+            }
+
+            // one message is handled by each call, the views of zero copy parser
+            // reference the buffer until the callback returns.
+            const auto retLen = http::HttpService::ProcessHttp(buffer,
+                                                               leftLen,
+                                                               httpParser,
+                                                               httpSession);
+            buffer += retLen;
+            leftLen -= retLen;
+            if (httpParser->hasError())
             {
                 httpSession->close();
+                break;
+            }
+            if (!httpParser->isCompleted() || httpSession->recvPaused())
+            {
+                break;
             }
         }
 
-        reader.addPos(retLen);
+        reader.addPos(reader.size() - leftLen);
         reader.savePos();
     };
 
@@ -109,11 +211,7 @@ std::tuple<TcpSession::DataHandler, TcpSession::EofHandler, TcpSession::ClosedHa
     };
 
     auto eofHandler = [=](const TcpSession::Ptr& session) {
-        // try pass EOF to http parser
-        if (!httpParser->isCompleted())
-        {
-            http::HttpService::ProcessHttp(nullptr, 0, httpParser, httpSession);
-        }
+        http::HttpService::ProcessEof(httpParser, httpSession);
     };
 
     return {dataHandler, eofHandler, closedHandler};
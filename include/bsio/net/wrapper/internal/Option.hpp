@@ -17,6 +17,10 @@ struct TcpSessionOption final {
     TcpSession::DataHandler dataHandler;
     TcpSession::ClosedHandler closedHandler;
     TcpSession::EofHandler eofHandler;
+    TcpSessionTimeout timeout;
+    bool useStrand = false;
+    TcpSession::UserDataInit userDataInit;
+    MemoryBudget::Ptr memoryBudget;
 };
 
 }// namespace bsio::net::wrapper::internal
@@ -32,11 +32,64 @@ public:
         return static_cast<Derived &>(*this);
     }
 
+    Derived &WithIdleTimeout(std::chrono::nanoseconds timeout) noexcept
+    {
+        mTcpSessionOption.timeout.idle = timeout;
+        return static_cast<Derived &>(*this);
+    }
+
+    Derived &WithReadTimeout(std::chrono::nanoseconds timeout) noexcept
+    {
+        mTcpSessionOption.timeout.read = timeout;
+        return static_cast<Derived &>(*this);
+    }
+
+    Derived &WithWriteTimeout(std::chrono::nanoseconds timeout) noexcept
+    {
+        mTcpSessionOption.timeout.write = timeout;
+        return static_cast<Derived &>(*this);
+    }
+
+    // construct user data of type T in the slot of every session before establish handlers.
+    template<typename T, typename... Args>
+    Derived &WithUserData(Args... args)
+    {
+        return WithUserDataInit([=](TcpSession &session) {
+            session.emplaceUserData<T>(args...);
+        });
+    }
+
+    Derived &WithUserDataInit(TcpSession::UserDataInit init) noexcept
+    {
+        mTcpSessionOption.userDataInit = std::move(init);
+        return static_cast<Derived &>(*this);
+    }
+
+    // required if the io_context of session is run by multi threads.
+    Derived &WithStrand() noexcept
+    {
+        mTcpSessionOption.useStrand = true;
+        return static_cast<Derived &>(*this);
+    }
+
+    // sessions sharing the budget are limited by its policy.
+    Derived &WithMemoryBudget(MemoryBudget::Ptr budget) noexcept
+    {
+        mTcpSessionOption.memoryBudget = std::move(budget);
+        return static_cast<Derived &>(*this);
+    }
+
     [[nodiscard]] const internal::TcpSessionOption &Option() const
     {
         return mTcpSessionOption;
     }
 
+    // move the option out rather than copying its handlers.
+    [[nodiscard]] internal::TcpSessionOption TakeOption()
+    {
+        return std::move(mTcpSessionOption);
+    }
+
 protected:
     void clear()
     {